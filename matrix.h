@@ -20,12 +20,55 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <limits>
 #include <memory>
 
 #include "matrix_exception.h"
 
 namespace mn {
 
+namespace detail {
+
+/**
+ * \brief State shared by copies of copy-on-write matrix
+ *
+ * Submatrices remember generation of their parent. It is incremented when
+ * memory block shared by copies is left by one of them, so submatrices
+ * created before that cannot tell which copy they belong to anymore.
+*/
+struct cow_state
+{
+	std::atomic<unsigned> generation; //!< Generation of submatrices which may write to memory block (never 0)
+
+	cow_state() : generation(1) {} //!< Default constructor
+};
+
+}
+
+/**
+ * \brief Order in which elements of matrix are stored in memory block
+*/
+enum class layout
+{
+	row_major, //!< Elements of every row are stored one after another
+	col_major //!< Elements of every column are stored one after another
+};
+
+/**
+ * \brief mn::matrix<T, L>
+ *
+ * Two-dimensional matrix containing elements of type T stored in layout L.
+ * Row-major matrix (default, mn::matrix<T>) is the one all operations are
+ * implemented for. Column-major matrix (see mn::matrix<T, layout::col_major>)
+ * keeps columns contiguous and is understood by kernels, iterators and
+ * stream operators.
+*/
+template<typename T, layout L = layout::row_major>
+class matrix;
+
 /**
  * \brief mn::matrix<T>
  *
@@ -34,7 +77,7 @@ namespace mn {
  * determinant calculation, transposition) and arithmetic operators.
 */
 template<typename T>
-class matrix
+class matrix<T, layout::row_major>
 {
 public:
 	class row_iterator;
@@ -45,20 +88,33 @@ public:
 	class const_element_iterator;
 	class iterator;
 	class const_iterator;
+	typedef T value_type; //!< Type of matrix elements
 protected:
 	class properties;
 	std::shared_ptr<T> mem_block;
 	properties p;
+	std::shared_ptr<detail::cow_state> cow_token;
+	std::weak_ptr<detail::cow_state> cow_parent;
+	unsigned cow_generation;
+
+	static std::shared_ptr<T> allocate(int rows, int cols);
+	void reallocate(int capacity);
+	matrix<T> region(int r_begin, int r_end, int c_begin, int c_end) const;
 public:
 	matrix();
 	matrix(int rows, int cols);
 	matrix(int rows_cols);
+	matrix(std::shared_ptr<T> mem_block, int rows, int cols);
+	template<typename D>
+	matrix(T* data, int rows, int cols, D deleter);
 
 	static matrix<T> zeros(int rows, int cols);
 	static matrix<T> zeros(int rows_cols);
 	static matrix<T> ones(int rows, int cols);
 	static matrix<T> ones(int rows_cols);
 	static matrix<T> identity(int rows_cols);
+	static matrix<T> wrap(T* data, int rows, int cols);
+	static matrix<T> wrap(T* data, int rows, int cols, int stride);
 
 	template<typename R>
 	static matrix<T> rand(int rows, int cols, R& random_distribution);
@@ -67,8 +123,12 @@ public:
 
 	const int rows() const;
 	const int cols() const;
+	std::ptrdiff_t size() const;
 	bool is_continuous() const;
 	bool is_square() const;
+	int stride() const;
+	T* row_data(const int index);
+	const T* row_data(const int index) const;
 
 	row_iterator operator[](const int index);
 	const_row_iterator operator[](const int index) const;
@@ -107,13 +167,35 @@ public:
 
 	T det() const;
 
+	template<typename F>
+	matrix<T> map(F f) const;
+	template<typename F>
+	matrix<T> zip_with(const matrix<T>& m, F f) const;
+	template<typename F>
+	matrix<T>& transform(F f);
+	template<typename F>
+	matrix<T>& transform(const matrix<T>& m, F f);
+
+	matrix<T> submatrix(int rows_from, int rows_to, int cols_from, int cols_to);
 	matrix<T> submatrix(int rows_from, int rows_to, int cols_from, int cols_to) const;
+	matrix<T> view(int rows_from, int rows_to, int cols_from, int cols_to);
+	matrix<T> view(int rows_from, int rows_to, int cols_from, int cols_to) const;
 	matrix<T> transpose() const;
-	matrix<T> append_h(matrix<T> m) const;
-	matrix<T> append_v(matrix<T> m) const;
+	matrix<T> append_h(const matrix<T>& m) const;
+	matrix<T> append_v(const matrix<T>& m) const;
 	matrix<T> copy() const;
 	T* raw();
 
+	void set_copy_on_write(bool enabled);
+	bool is_copy_on_write() const;
+	void detach();
+
+	int capacity() const;
+	void reserve(int rows);
+	void push_row(const T* values);
+	void push_row(const matrix<T>& row);
+	T* emplace_row();
+
 	iterator begin();
 	const_iterator begin() const;
 	iterator end();
@@ -138,7 +220,7 @@ public:
 	 * \brief Default constructor
 	*/
 	properties() :
-		rows(1), cols(1), r_begin(0), r_end(0), c_begin(0), c_end(0), continuous(true) {}
+		rows(1), cols(1), capacity(1), r_begin(0), r_end(0), c_begin(0), c_end(0), continuous(true) {}
 
 	/**
 	 * \brief Constructor with number of rows and columns
@@ -147,7 +229,7 @@ public:
 	 * \param cols Number of columns
 	*/
 	properties(int rows, int cols) :
-		rows(rows), cols(cols), r_begin(0), r_end(rows - 1), c_begin(0), c_end(cols - 1), continuous(true) {}
+		rows(rows), cols(cols), capacity(rows), r_begin(0), r_end(rows - 1), c_begin(0), c_end(cols - 1), continuous(true) {}
 
 	/**
 	 * \brief Constructor with size (single number for both rows and column)
@@ -155,7 +237,7 @@ public:
 	 * \param rows_cols Matrix size (number of rows and columns)
 	*/
 	properties(int rows_cols) :
-		rows(rows_cols), cols(rows_cols), r_begin(0), r_end(rows - 1), c_begin(0), c_end(cols - 1), continuous(true) {}
+		rows(rows_cols), cols(rows_cols), capacity(rows_cols), r_begin(0), r_end(rows - 1), c_begin(0), c_end(cols - 1), continuous(true) {}
 
 	/**
 	 * \brief Compares two matrix<T>::properties objects
@@ -170,8 +252,9 @@ public:
 	 * Returns true if both objects are different.
 	*/
 	bool operator!=(const properties& p) const { return !operator==(p); }
-	int rows; //!< Number of rows in matrix
+	int rows; //!< Number of initialized rows of memory block
 	int cols; //!< Number of columns in matrix
+	int capacity; //!< Number of rows allocated in memory block (may exceed rows if reserved)
 	int r_begin; //!< Index of first row in submatrix
 	int r_end; //!< Index of last row in submatrix
 	int c_begin; //!< Index of first column in submatrix
@@ -315,6 +398,7 @@ public:
 	col_iterator operator++(int);
 	col_iterator& operator--();
 	col_iterator operator--(int);
+	T& operator[](const int index);
 	typename matrix<T>::element_iterator first_element();
 	typename matrix<T>::element_iterator last_element();
 };
@@ -361,6 +445,7 @@ public:
 	const_col_iterator operator++(int);
 	const_col_iterator& operator--();
 	const_col_iterator operator--(int);
+	const T& operator[](const int index);
 	typename matrix<T>::const_element_iterator first_element();
 	typename matrix<T>::const_element_iterator last_element();
 };
@@ -586,7 +671,7 @@ public:
 */
 template<typename T>
 inline matrix<T>::matrix() :
-	mem_block(new T[1], [](T* ptr) { delete[] ptr; })
+	mem_block(new T[1], [](T* ptr) { delete[] ptr; }), cow_generation(0)
 {
 }
 
@@ -598,10 +683,11 @@ inline matrix<T>::matrix() :
  *
  * \param rows Number of matrix rows
  * \param cols Number of matrix columns
+ * \throws mn::matrix_exception
 */
 template<typename T>
 inline matrix<T>::matrix(int rows, int cols) :
-	mem_block(new T[rows * cols], [](T* ptr) { delete[] ptr; }), p(rows, cols)
+	mem_block(allocate(rows, cols)), p(rows, cols), cow_generation(0)
 {
 }
 
@@ -612,10 +698,49 @@ inline matrix<T>::matrix(int rows, int cols) :
  * Matrix elements are uninitialized.
  *
  * \param rows_cols Number of matrix rows and columns
+ * \throws mn::matrix_exception
 */
 template<typename T>
 inline matrix<T>::matrix(int rows_cols) :
-	mem_block(new T[rows_cols * rows_cols], [](T* ptr) {delete[] ptr; }), p(rows_cols)
+	mem_block(allocate(rows_cols, rows_cols)), p(rows_cols), cow_generation(0)
+{
+}
+
+/**
+ * \brief Constructor with existing memory block
+ *
+ * Creates new matrix using memory block passed as argument, which has to
+ * contain at least rows * cols elements stored row-by-row. Memory block
+ * is shared with caller and released by its deleter when no longer used.
+ *
+ * \param mem_block Shared pointer to memory block
+ * \param rows Number of matrix rows
+ * \param cols Number of matrix columns
+*/
+template<typename T>
+inline matrix<T>::matrix(std::shared_ptr<T> mem_block, int rows, int cols) :
+	mem_block(mem_block), p(rows, cols), cow_generation(0)
+{
+}
+
+/**
+ * \brief Constructor adopting existing memory block
+ *
+ * Creates new matrix using memory block passed as argument, which has to
+ * contain at least rows * cols elements stored row-by-row. Matrix takes
+ * ownership of memory block, which is released with deleter (called as
+ * deleter(data)) when no longer used. No elements are copied. Memory
+ * blocks without owner may be wrapped with mn::matrix::wrap.
+ *
+ * \param data Pointer to memory block
+ * \param rows Number of matrix rows
+ * \param cols Number of matrix columns
+ * \param deleter Function releasing memory block
+*/
+template<typename T>
+template<typename D>
+inline matrix<T>::matrix(T* data, int rows, int cols, D deleter) :
+	mem_block(data, deleter), p(rows, cols), cow_generation(0)
 {
 }
 
@@ -641,6 +766,20 @@ inline const int matrix<T>::cols() const
 	return p.c_end - p.c_begin + 1;
 }
 
+/**
+ * \brief Returns number of elements of matrix
+ *
+ * Number of elements may exceed range of int, even though numbers of rows
+ * and columns never do.
+ *
+ * \return Number of elements
+*/
+template<typename T>
+inline std::ptrdiff_t matrix<T>::size() const
+{
+	return static_cast<std::ptrdiff_t>(rows()) * cols();
+}
+
 /**
  * \brief Returns true if matrix is continuous, i.e. it is not submatrix of other matrix.
  *
@@ -668,6 +807,50 @@ inline bool matrix<T>::is_square() const
 	return rows() == cols();
 }
 
+/**
+ * \brief Returns distance between beginnings of consecutive rows
+ *
+ * For continuous matrix it equals number of columns, while for submatrix
+ * it equals number of columns of original matrix.
+ *
+ * \return Row stride (in elements)
+*/
+template<typename T>
+inline int matrix<T>::stride() const
+{
+	return p.cols;
+}
+
+/**
+ * \brief Returns raw pointer to first element of specified row
+ *
+ * Elements of single row are always stored in memory one after another,
+ * so the pointer may be used to access cols() elements. Works for
+ * submatrices too. Copy-on-write matrix is detached first (see mn::matrix::detach).
+ *
+ * \param index Row index (zero-based)
+ * \return Raw pointer to first element of row
+*/
+template<typename T>
+inline T* matrix<T>::row_data(const int index)
+{
+	if (cow_token || cow_generation != 0)
+		detach();
+	return mem_block.get() + static_cast<std::ptrdiff_t>(p.cols) * (p.r_begin + index) + p.c_begin;
+}
+
+/**
+ * \brief Returns raw pointer to first element of specified row of constant matrix
+ *
+ * \param index Row index (zero-based)
+ * \return Raw pointer to first element of row
+*/
+template<typename T>
+inline const T* matrix<T>::row_data(const int index) const
+{
+	return mem_block.get() + static_cast<std::ptrdiff_t>(p.cols) * (p.r_begin + index) + p.c_begin;
+}
+
 /**
  * \brief Returns row iterator for specified row index
  *
@@ -700,6 +883,7 @@ inline typename matrix<T>::const_row_iterator matrix<T>::operator[](const int in
 template<typename T>
 inline typename matrix<T>::row_iterator matrix<T>::first_row()
 {
+	detach();
 	return row_iterator(mem_block, p, p.r_begin);
 }
 
@@ -722,6 +906,7 @@ inline typename matrix<T>::const_row_iterator matrix<T>::first_row() const
 template<typename T>
 inline typename matrix<T>::row_iterator matrix<T>::last_row()
 {
+	detach();
 	return row_iterator(mem_block, p, p.r_end + 1);
 }
 
@@ -744,6 +929,7 @@ inline typename matrix<T>::const_row_iterator matrix<T>::last_row() const
 template<typename T>
 inline typename matrix<T>::col_iterator matrix<T>::first_col()
 {
+	detach();
 	return col_iterator(mem_block, p, p.c_begin);
 }
 
@@ -766,6 +952,7 @@ inline typename matrix<T>::const_col_iterator matrix<T>::first_col() const
 template<typename T>
 inline typename matrix<T>::col_iterator matrix<T>::last_col()
 {
+	detach();
 	return col_iterator(mem_block, p, p.c_end + 1);
 }
 
@@ -789,6 +976,7 @@ inline typename matrix<T>::const_col_iterator matrix<T>::last_col() const
 template<typename T>
 inline typename matrix<T>::row_iterator matrix<T>::row(const int index)
 {
+	detach();
 	return row_iterator(mem_block, p, p.r_begin + index);
 }
 
@@ -813,6 +1001,7 @@ inline typename matrix<T>::const_row_iterator matrix<T>::row(const int index) co
 template<typename T>
 inline typename matrix<T>::col_iterator matrix<T>::col(const int index)
 {
+	detach();
 	return col_iterator(mem_block, p, p.c_begin + index);
 }
 
@@ -833,7 +1022,33 @@ inline typename matrix<T>::const_col_iterator matrix<T>::col(const int index) co
  *
  * This method creates new matrix object which points to the same memory block
  * as origin matrix, but recalculates indexes and iterators to allow access only
- * to specified region.
+ * to specified region. Region indexes refer to the whole memory block, also
+ * when called on submatrix (use view() for indexes relative to submatrix).
+ * Copy-on-write matrix is detached first, so writes through submatrix never
+ * reach its copies.
+ *
+ * \param rows_from	First row index of region
+ * \param rows_to	Last row index of region
+ * \param cols_from	First column index of region
+ * \param cols_to	Last column index of region
+ * \return mn::matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> matrix<T>::submatrix(int rows_from, int rows_to, int cols_from, int cols_to)
+{
+	if (cow_token)
+		detach();
+	return static_cast<const matrix<T>&>(*this).submatrix(rows_from, rows_to, cols_from, cols_to);
+}
+
+/**
+ * \brief Returns submatrix pointing to specified region of constant matrix
+ *
+ * Works like non-const version, but copy-on-write matrix is not detached.
+ * Writing through submatrix of copy-on-write matrix throws exception as
+ * long as its memory block is shared with other copies, or if any copy
+ * stopped sharing it since submatrix was created.
  *
  * \param rows_from	First row index of region
  * \param rows_to	Last row index of region
@@ -845,197 +1060,314 @@ inline typename matrix<T>::const_col_iterator matrix<T>::col(const int index) co
 template<typename T>
 inline matrix<T> matrix<T>::submatrix(int rows_from, int rows_to, int cols_from, int cols_to) const
 {
-	matrix<T> subm = matrix(*this);
 	if (rows_from < 0 || rows_to >= p.rows || cols_from < 0 || cols_to >= p.cols)
 		throw matrix_exception("region out of bounds");
 	if (rows_from > rows_to || cols_from > cols_to)
 		throw matrix_exception("invalid region");
-	subm.p.continuous = false;
-	subm.p.r_begin = rows_from;
-	subm.p.r_end = rows_to;
-	subm.p.c_begin = cols_from;
-	subm.p.c_end = cols_to;
+	return region(rows_from, rows_to, cols_from, cols_to);
+}
 
-	return subm;
+/**
+ * \brief Returns submatrix pointing to region of current matrix
+ *
+ * Works like submatrix(), but region indexes are relative to current
+ * matrix, so views of submatrices (e.g. quadrants of blocks) may be created.
+ *
+ * \param rows_from	First row index of region
+ * \param rows_to	Last row index of region
+ * \param cols_from	First column index of region
+ * \param cols_to	Last column index of region
+ * \return mn::matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> matrix<T>::view(int rows_from, int rows_to, int cols_from, int cols_to)
+{
+	if (cow_token)
+		detach();
+	return static_cast<const matrix<T>&>(*this).view(rows_from, rows_to, cols_from, cols_to);
 }
 
 /**
- * \brief Returns transposed matrix
+ * \brief Returns submatrix pointing to region of current constant matrix
  *
- * This method allocates new memory block and copies original matrix to it,
- * but it also swaps rows and columns and then returns new transposed matrix.
+ * Copy-on-write matrix is not detached, like in const version of submatrix().
  *
+ * \param rows_from	First row index of region
+ * \param rows_to	Last row index of region
+ * \param cols_from	First column index of region
+ * \param cols_to	Last column index of region
  * \return mn::matrix
+ * \throws mn::matrix_exception
 */
 template<typename T>
-inline matrix<T> matrix<T>::transpose() const
+inline matrix<T> matrix<T>::view(int rows_from, int rows_to, int cols_from, int cols_to) const
 {
-	matrix<T> transposed = matrix<T>(cols(), rows());
-	auto src_row = first_row();
-	auto dst_col = transposed.first_col();
-	while (src_row != last_row() && dst_col != transposed.last_col())
+	if (rows_from < 0 || rows_to >= rows() || cols_from < 0 || cols_to >= cols())
+		throw matrix_exception("region out of bounds");
+	if (rows_from > rows_to || cols_from > cols_to)
+		throw matrix_exception("invalid region");
+	return region(p.r_begin + rows_from, p.r_begin + rows_to, p.c_begin + cols_from, p.c_begin + cols_to);
+}
+
+/**
+ * \brief Returns submatrix of region of memory block given by absolute indexes
+*/
+template<typename T>
+inline matrix<T> matrix<T>::region(int r_begin, int r_end, int c_begin, int c_end) const
+{
+	matrix<T> subm = matrix(*this);
+	subm.p.continuous = false;
+	subm.p.r_begin = r_begin;
+	subm.p.r_end = r_end;
+	subm.p.c_begin = c_begin;
+	subm.p.c_end = c_end;
+	if (cow_token)
 	{
-		auto src_element = src_row.first_element();
-		auto dst_element = dst_col.first_element();
-		while (src_element != src_row.last_element() && dst_element != dst_col.last_element())
-		{
-			*dst_element = *src_element;
-			++src_element;
-			++dst_element;
-		}
-		++src_row;
-		++dst_col;
+		subm.cow_parent = cow_token;
+		subm.cow_generation = cow_token->generation;
+		subm.cow_token.reset();
 	}
 
-	return transposed;
+	return subm;
 }
 
 /**
- * \brief Copies matrix and appends another one horizontally
+ * \brief Performs explicit matrix copy
  *
- * This method creates and allocates new matrix, copies original matrix
- * to it, and appends second matrix (passed as an argument) horizontally.
- * If numbers of rows don't match, empty values are initialized to zeros.
+ * To save memory, all matrix objects clones and copies made
+ * by assignment operator are only "pointers" to a single memory block.
+ * This method creates new matrix, allocates new memory block for it
+ * and copies original matrix contents to it, row by row (see mn::copy_block).
+ * If original matrix is submatrix, then only subregion is copied.
+ * Copy-on-write matrix is not copied until either copy is modified, so
+ * this method returns shared copy in O(1) time.
  *
- * \param m Matrix to append to original
  * \return mn::matrix
 */
 template<typename T>
-inline matrix<T> matrix<T>::append_h(matrix<T> m) const
+inline matrix<T> matrix<T>::copy() const
 {
-	int rows_n = (rows() > m.rows()) ? rows() : m.rows();
-	matrix<T> appended(rows_n, cols() + m.cols());
-	for (int r = 0; r < rows(); ++r)
-	{
-		for (int c = 0; c < cols(); ++c)
-		{
-			appended[r][c] = (*this)[r][c];
-		}
-	}
-	for (int r = 0; r < m.rows(); ++r)
-	{
-		for (int c = 0; c < m.cols(); ++c)
-		{
-			appended[r][c + cols()] = m[r][c];
-		}
-	}
-	if (rows() > m.rows())
-	{
-		for (int r = m.rows(); r < appended.rows(); ++r)
-		{
-			for (int c = cols(); c < appended.cols(); ++c)
-			{
-				appended[r][c] = 0;
-			}
-		}
-	}
-	else
-	{
-		for (int r = rows(); r < appended.rows(); ++r)
-		{
-			for (int c = 0; c < cols(); ++c)
-			{
-				appended[r][c] = 0;
-			}
-		}
-	}
+	if (cow_token)
+		return *this;
+	matrix<T> copy = matrix<T>(rows(), cols());
+	copy_block(*this, copy);
 
-	return appended;
+	return copy;
 }
 
 /**
- * \brief Copies matrix and appends another one vertically
+ * \brief Returns raw pointer to matrix memory block
  *
- * This method creates and allocates new matrix, copies original matrix
- * to it, and appends second matrix (passed as an argument) vertically.
- * If numbers of columns don't match, empty values are initialized to zeros.
+ * All matrices are stored in memory as one continuous block, row-by-row.
+ * Sometimes it may be useful to directly access this block, e.g. for
+ * serializing or some other purposes. Be careful, as for submatrices it
+ * returns pointer to whole block, not only for subregion. Check it with
+ * is_continuous() first. Copy-on-write matrix is detached first.
  *
- * \param m Matrix to append to original
- * \return mn::matrix
+ * \return Raw pointer to matrix memory block
+*/
+template<typename T>
+inline T* matrix<T>::raw()
+{
+	detach();
+	return mem_block.get();
+}
+
+/**
+ * \brief Enables or disables copy-on-write mode of matrix
+ *
+ * By default copies of matrix made by copy constructor and assignment
+ * operator point to the same memory block, so modifying one modifies all.
+ * In copy-on-write mode copies (and results of copy()) still share memory
+ * block, but the first modification of matrix which shares it (through
+ * non-const operator[], iterators, row_data(), raw() or in-place
+ * operations) copies elements to new memory block first, so copies behave
+ * like independent values and defensive copies cost nothing until written.
+ * Mode is inherited by copies. Read elements through const reference to
+ * avoid copying on access. Disabling the mode detaches matrix. Enabling it
+ * for submatrix of copy-on-write matrix copies the region.
+ *
+ * \param enabled True to enable copy-on-write
 */
 template<typename T>
-inline matrix<T> matrix<T>::append_v(matrix<T> m) const
+inline void matrix<T>::set_copy_on_write(bool enabled)
 {
-	int cols_n = (cols() > m.cols()) ? cols() : m.cols();
-	matrix<T> appended(rows() + m.rows(), cols_n);
-	for (int r = 0; r < rows(); ++r)
+	if (enabled && !cow_token)
 	{
-		for (int c = 0; c < cols(); ++c)
+		if (cow_generation != 0)
 		{
-			appended[r][c] = (*this)[r][c];
+			matrix<T> region(rows(), cols());
+			copy_block(static_cast<const matrix<T>&>(*this), region);
+			*this = region;
 		}
+		cow_token = std::make_shared<detail::cow_state>();
 	}
-	for (int r = 0; r < m.rows(); ++r)
+	else if (!enabled && cow_token)
 	{
-		for (int c = 0; c < m.cols(); ++c)
-		{
-			appended[r + rows()][c] = m[r][c];
-		}
+		detach();
+		cow_token.reset();
 	}
-	if (cols() > m.cols())
+}
+
+/**
+ * \brief Returns true if matrix is in copy-on-write mode
+ *
+ * \return True if copy-on-write is enabled
+*/
+template<typename T>
+inline bool matrix<T>::is_copy_on_write() const
+{
+	return static_cast<bool>(cow_token);
+}
+
+/**
+ * \brief Makes copy-on-write matrix the only owner of its elements
+ *
+ * If memory block is shared with other copies of copy-on-write matrix,
+ * elements are copied (in parallel) to new continuous memory block. Called
+ * implicitly by every non-const access; has to be called explicitly only
+ * before writing through row_data() from many threads. For submatrix of
+ * copy-on-write matrix it only checks that the submatrix may be written.
+ * Does nothing for other matrices. Iterators created before detaching
+ * still point to old memory block.
+ *
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void matrix<T>::detach()
+{
+	if (cow_token)
 	{
-		for (int r = rows(); r < appended.rows(); ++r)
+		if (cow_token.use_count() > 1)
 		{
-			for (int c = m.cols(); c < appended.cols(); ++c)
-			{
-				appended[r][c] = 0;
-			}
+			matrix<T> clone(rows(), cols());
+			copy_block(static_cast<const matrix<T>&>(*this), clone);
+			++cow_token->generation;
+			mem_block = clone.mem_block;
+			p = clone.p;
+			cow_token = std::make_shared<detail::cow_state>();
 		}
+		else
+			std::atomic_thread_fence(std::memory_order_acquire);
 	}
-	else
+	else if (cow_generation != 0)
 	{
-		for (int r = 0; r < rows(); ++r)
-		{
-			for (int c = cols(); c < appended.cols(); ++c)
-			{
-				appended[r][c] = 0;
-			}
-		}
+		std::shared_ptr<detail::cow_state> parent = cow_parent.lock();
+		if (parent && (parent.use_count() > 2 || parent->generation != cow_generation))
+			throw matrix_exception("submatrix of shared copy-on-write matrix");
 	}
+}
 
-	return appended;
+/**
+ * \brief Returns number of rows which may be stored without reallocation
+ *
+ * Rows may be added in place only to continuous matrix which is the only
+ * owner of its memory block. For all other matrices it equals rows().
+ *
+ * \return Number of rows
+*/
+template<typename T>
+inline int matrix<T>::capacity() const
+{
+	if (!p.continuous || mem_block.use_count() != 1)
+		return rows();
+	return p.capacity;
 }
 
 /**
- * \brief Performs explicit matrix copy
+ * \brief Reserves memory for specified number of rows
  *
- * To save memory, all matrix objects clones and copies made
- * by assignment operator are only "pointers" to a single memory block.
- * This method creates new matrix, allocates new memory block for it
- * and copies original matrix contents to it. If original matrix is
- * submatrix, then only subregion is copied.
+ * If capacity() is lower than requested number of rows, new memory block
+ * is allocated and current contents are copied to it. Submatrices and
+ * matrices sharing memory block with other objects are detached this way.
  *
- * \return mn::matrix
+ * \param rows Number of rows
 */
 template<typename T>
-inline matrix<T> matrix<T>::copy() const
+inline void matrix<T>::reserve(int rows)
 {
-	matrix<T> copy = matrix<T>(rows(), cols());
-	auto src = begin();
-	auto dst = copy.begin();
-	for (; src != end() && dst != copy.end(); ++src, ++dst)
-	{
-		*dst = *src;
-	}
+	if (capacity() < rows)
+		reallocate(rows);
+}
 
-	return copy;
+/**
+ * \brief Appends row at the bottom of matrix
+ *
+ * Copies cols() elements pointed by values. When capacity() is exceeded,
+ * memory block is reallocated with geometric growth, so appending N rows
+ * costs amortized O(N) element copies. Values may be row of the matrix itself.
+ *
+ * \param values Pointer to elements of new row
+*/
+template<typename T>
+inline void matrix<T>::push_row(const T* values)
+{
+	// Values may point into current memory block, so it is kept until they are copied
+	std::shared_ptr<T> old_block = capacity() == rows() ? mem_block : std::shared_ptr<T>();
+	T* row = emplace_row();
+	std::copy(values, values + cols(), row);
 }
 
 /**
- * \brief Returns raw pointer to matrix memory block
+ * \brief Appends row at the bottom of matrix
  *
- * All matrices are stored in memory as one continuous block, row-by-row.
- * Sometimes it may be useful to directly access this block, e.g. for
- * serializing or some other purposes. Be careful, as for submatrices it
- * returns pointer to whole block, not only for subregion. Check it with
- * is_continuous() first.
+ * \param row Matrix containing one row and cols() columns
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void matrix<T>::push_row(const matrix<T>& row)
+{
+	if (row.rows() != 1 || row.cols() != cols())
+		throw matrix_exception("dimensions mismatch");
+	push_row(row.row_data(0));
+}
+
+/**
+ * \brief Appends uninitialized row at the bottom of matrix
  *
- * \return Raw pointer to matrix memory block
+ * Allows to write new row directly into memory block, e.g. when parsing
+ * records. Returned pointer is valid until next reallocation.
+ *
+ * \return Raw pointer to first element of new row
 */
 template<typename T>
-inline T* matrix<T>::raw()
+inline T* matrix<T>::emplace_row()
 {
-	return mem_block.get();
+	if (capacity() == rows())
+	{
+		if (rows() == std::numeric_limits<int>::max())
+			throw matrix_exception("matrix too large");
+		reallocate(rows() + std::max(1, std::min(rows(), std::numeric_limits<int>::max() - rows())));
+	}
+	++p.r_end;
+	++p.rows;
+	return row_data(rows() - 1);
+}
+
+/**
+ * \brief Moves matrix contents to new continuous memory block
+ *
+ * \param capacity Number of rows of new memory block
+*/
+template<typename T>
+inline void matrix<T>::reallocate(int capacity)
+{
+	int rows_n = rows(), cols_n = cols();
+	const matrix<T>& self = *this;
+	std::shared_ptr<T> block = allocate(capacity, cols_n);
+	for (int r = 0; r < rows_n; ++r)
+		std::copy(self.row_data(r), self.row_data(r) + cols_n, block.get() + static_cast<std::ptrdiff_t>(r) * cols_n);
+	mem_block = block;
+	p = properties(rows_n, cols_n);
+	p.capacity = capacity;
+	cow_parent.reset();
+	cow_generation = 0;
+	if (cow_token)
+	{
+		++cow_token->generation;
+		cow_token = std::make_shared<detail::cow_state>();
+	}
 }
 
 /**
@@ -1046,6 +1378,7 @@ inline T* matrix<T>::raw()
 template<typename T>
 inline typename matrix<T>::iterator matrix<T>::begin()
 {
+	detach();
 	return iterator(mem_block, p, p.r_begin, p.c_begin);
 }
 
@@ -1068,6 +1401,7 @@ inline typename matrix<T>::const_iterator matrix<T>::begin() const
 template <typename T>
 inline typename matrix<T>::iterator matrix<T>::end()
 {
+	detach();
 	return iterator(mem_block, p, -1, -1);
 }
 
@@ -1085,6 +1419,23 @@ inline typename matrix<T>::const_iterator matrix<T>::end() const
 }
 
 #include "matrix_generators.h"
+#include "matrix_parallel.h"
+#include "matrix_memory.h"
+#include "matrix_pool.h"
+#include "matrix_precision.h"
+#include "matrix_concat.h"
+#include "matrix_interop.h"
+#include "matrix_layout.h"
+#include "matrix_shared.h"
+#include "matrix_mapped.h"
+#include "matrix_elementwise.h"
+#include "matrix_math.h"
+#include "matrix_blas.h"
+#include "matrix_strassen.h"
+#include "matrix_quantized.h"
+#include "matrix_reductions.h"
+#include "matrix_compare.h"
+#include "matrix_broadcast.h"
 #include "matrix_operators.h"
 #include "matrix_iterators.h"
 #include "matrix_io.h"
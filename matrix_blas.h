@@ -0,0 +1,753 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+#include "matrix_exception.h"
+#include "matrix_parallel.h"
+#include "matrix_precision.h"
+
+namespace mn {
+
+/**
+ * \brief Selects whether kernel operand is used as is or transposed
+*/
+enum class transposition
+{
+	none, //!< Operand is used as is
+	transposed //!< Operand is used transposed
+};
+
+namespace detail {
+
+/**
+ * \brief Returns thread-local scratch buffers of element type T
+*/
+template<typename T>
+inline std::vector<T>* scratch_buffers()
+{
+	static thread_local std::vector<T> buffers[4];
+	return buffers;
+}
+
+/**
+ * \brief Returns thread-local scratch buffer
+ *
+ * Buffer is grown when needed and reused by subsequent calls on the same
+ * thread. Different slots may be used at the same time.
+ *
+ * \param n Minimal number of elements
+ * \param slot Index of buffer (0-3)
+ * \return Pointer to buffer
+*/
+template<typename T>
+inline T* scratch(std::size_t n, int slot)
+{
+	std::vector<T>& buffer = scratch_buffers<T>()[slot];
+	if (buffer.size() < n)
+		buffer.resize(n);
+	return buffer.data();
+}
+
+/**
+ * \brief Frees thread-local scratch buffer
+ *
+ * \param slot Index of buffer (0-3)
+*/
+template<typename T>
+inline void release_scratch(int slot)
+{
+	std::vector<T>().swap(scratch_buffers<T>()[slot]);
+}
+
+/**
+ * \brief Calculates dot product of two contiguous arrays
+ *
+ * Uses several independent accumulators, so the loop may be vectorized
+ * and pipelined by compiler.
+*/
+template<typename A>
+inline A dot_kernel(const A* x, const A* y, int n)
+{
+	A s0 = 0, s1 = 0, s2 = 0, s3 = 0, s4 = 0, s5 = 0, s6 = 0, s7 = 0;
+	int i = 0;
+	for (; i + 8 <= n; i += 8)
+	{
+		s0 += x[i] * y[i];
+		s1 += x[i + 1] * y[i + 1];
+		s2 += x[i + 2] * y[i + 2];
+		s3 += x[i + 3] * y[i + 3];
+		s4 += x[i + 4] * y[i + 4];
+		s5 += x[i + 5] * y[i + 5];
+		s6 += x[i + 6] * y[i + 6];
+		s7 += x[i + 7] * y[i + 7];
+	}
+	for (; i < n; ++i)
+		s0 += x[i] * y[i];
+	return ((s0 + s1) + (s2 + s3)) + ((s4 + s5) + (s6 + s7));
+}
+
+/**
+ * \brief Calculates dot product of two contiguous arrays in accumulator type A
+ *
+ * Elements of other types are converted to A in short chunks first.
+*/
+template<typename A, typename T>
+inline A dot(const T* x, const T* y, int n)
+{
+	A xs[256], ys[256];
+	int chunk = std::is_same<A, T>::value ? std::max(n, 1) : 256;
+	A s = 0;
+	for (int i = 0; i < n; i += chunk)
+	{
+		int len = std::min(chunk, n - i);
+		s += dot_kernel(converted(x + i, len, xs), converted(y + i, len, ys), len);
+	}
+	return s;
+}
+
+/**
+ * \brief Adds scaled contiguous array to another one (y += alpha * x)
+ *
+ * Calculations are performed in type of alpha.
+*/
+template<typename A, typename X, typename Y>
+inline void axpy(A alpha, const X* x, Y* y, int n)
+{
+	for (int i = 0; i < n; ++i)
+		y[i] = static_cast<Y>(static_cast<A>(y[i]) + alpha * static_cast<A>(x[i]));
+}
+
+/**
+ * \brief Scales contiguous array (y *= beta)
+ *
+ * If beta is zero, array is filled with zeros regardless of its contents.
+*/
+template<typename T>
+inline void scal(T beta, T* y, int n)
+{
+	if (beta == T(0))
+	{
+		for (int i = 0; i < n; ++i)
+			y[i] = 0;
+	}
+	else if (beta != T(1))
+	{
+		for (int i = 0; i < n; ++i)
+			y[i] *= beta;
+	}
+}
+
+/**
+ * \brief Returns number of elements of matrix treated as vector
+ *
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline int vector_size(const matrix<T>& v)
+{
+	if (v.cols() == 1)
+		return v.rows();
+	if (v.rows() == 1)
+		return v.cols();
+	throw matrix_exception("not a vector");
+}
+
+/**
+ * \brief Returns distance between consecutive elements of matrix treated as vector
+*/
+template<typename T>
+inline int vector_inc(const matrix<T>& v)
+{
+	return v.cols() == 1 ? v.stride() : 1;
+}
+
+/**
+ * \brief Returns pointer to contiguous copy of vector elements
+ *
+ * If vector is already contiguous, pointer to its own elements is returned.
+*/
+template<typename T>
+inline const T* contiguous(const T* v, int inc, int n, int slot)
+{
+	if (inc == 1)
+		return v;
+	T* packed = scratch<T>(n, slot);
+	for (int i = 0; i < n; ++i)
+		packed[i] = v[static_cast<std::ptrdiff_t>(i) * inc];
+	return packed;
+}
+
+}
+
+/**
+ * \brief Multiplies matrix by vector (y = alpha * A * x + beta * y)
+ *
+ * Both x and y may be row or column vectors, including submatrices.
+ * When transposition is requested, y = alpha * A^T * x + beta * y is
+ * calculated instead. Rows of A are processed in parallel. If beta is zero,
+ * y does not have to be initialized. Vectors must not share memory with A
+ * or with each other. Products are accumulated in type A (see mn::accumulator).
+ *
+ * \param alpha Scaling factor of product
+ * \param a Matrix A
+ * \param x Vector x
+ * \param beta Scaling factor of y
+ * \param y Vector y (result)
+ * \param trans Transposition of A
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline void gemv(const typename matrix<T>::value_type& alpha, const matrix<T>& a, const matrix<T>& x,
+	const typename matrix<T>::value_type& beta, matrix<T>& y, transposition trans = transposition::none)
+{
+	int m = trans == transposition::none ? a.rows() : a.cols();
+	int n = trans == transposition::none ? a.cols() : a.rows();
+	if (detail::vector_size(x) != n || detail::vector_size(y) != m)
+		throw matrix_exception("dimensions mismatch");
+
+	int incy = detail::vector_inc(y);
+	const T* xp = x.row_data(0);
+	T* yp = y.row_data(0);
+	if (trans == transposition::none)
+	{
+		xp = detail::contiguous(xp, detail::vector_inc(x), n, 0);
+		parallel_for(0, m, parallel_grain(n), [&](int begin, int end)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				A s = static_cast<A>(alpha) * detail::dot<A>(a.row_data(i), xp, n);
+				T& yi = yp[static_cast<std::ptrdiff_t>(i) * incy];
+				yi = static_cast<T>((beta == T(0)) ? s : static_cast<A>(beta) * static_cast<A>(yi) + s);
+			}
+		});
+	}
+	else
+	{
+		int incx = detail::vector_inc(x);
+		A* yw = detail::scratch<A>(m, 1);
+		for (int j = 0; j < m; ++j)
+			yw[j] = static_cast<A>(yp[static_cast<std::ptrdiff_t>(j) * incy]);
+		detail::scal(static_cast<A>(beta), yw, m);
+		parallel_for(0, m, std::max(16, parallel_grain(n)), [&](int begin, int end)
+		{
+			for (int i = 0; i < n; ++i)
+			{
+				A xi = static_cast<A>(alpha) * static_cast<A>(xp[static_cast<std::ptrdiff_t>(i) * incx]);
+				detail::axpy(xi, a.row_data(i) + begin, yw + begin, end - begin);
+			}
+		});
+		for (int j = 0; j < m; ++j)
+			yp[static_cast<std::ptrdiff_t>(j) * incy] = static_cast<T>(yw[j]);
+	}
+}
+
+/**
+ * \brief Performs rank-1 update of matrix (A = alpha * x * y^T + A)
+ *
+ * Both x and y may be row or column vectors, including submatrices.
+ * Rows of A are updated in parallel, calculations are performed in type A.
+ *
+ * \param alpha Scaling factor of update
+ * \param x Vector x (number of elements equal to number of rows of A)
+ * \param y Vector y (number of elements equal to number of columns of A)
+ * \param a Matrix A (result)
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline void ger(const typename matrix<T>::value_type& alpha, const matrix<T>& x, const matrix<T>& y, matrix<T>& a)
+{
+	int m = a.rows();
+	int n = a.cols();
+	if (detail::vector_size(x) != m || detail::vector_size(y) != n)
+		throw matrix_exception("dimensions mismatch");
+	a.detach();
+
+	int incx = detail::vector_inc(x);
+	const T* xp = x.row_data(0);
+	const T* yp = detail::contiguous(y.row_data(0), detail::vector_inc(y), n, 0);
+	parallel_for(0, m, parallel_grain(n), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+			detail::axpy(static_cast<A>(alpha) * static_cast<A>(xp[static_cast<std::ptrdiff_t>(i) * incx]), yp, detail::view_row(a, i), n);
+	});
+}
+
+/**
+ * \brief Performs symmetric rank-k update of matrix (C = alpha * A * A^T + beta * C)
+ *
+ * When transposition is requested, C = alpha * A^T * A + beta * C is
+ * calculated instead. Only upper triangle of C is read, but whole C
+ * is written, i.e. lower triangle is mirrored from upper one. If beta is
+ * zero, C does not have to be initialized. Rows of C are updated in
+ * parallel, products are accumulated in type A and every element of C is
+ * rounded to type T once.
+ *
+ * \param alpha Scaling factor of product
+ * \param a Matrix A
+ * \param beta Scaling factor of C
+ * \param c Square matrix C (result)
+ * \param trans Transposition of A
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline void syrk(const typename matrix<T>::value_type& alpha, const matrix<T>& a,
+	const typename matrix<T>::value_type& beta, matrix<T>& c, transposition trans = transposition::none)
+{
+	int n = trans == transposition::none ? a.rows() : a.cols();
+	int k = trans == transposition::none ? a.cols() : a.rows();
+	if (c.rows() != n || c.cols() != n)
+		throw matrix_exception("dimensions mismatch");
+	c.detach();
+
+	// Row i of upper triangle is processed together with row n - 1 - i to balance tasks.
+	// It is accumulated in thread-local row of type A and stored in C once.
+	auto upper_row = [&](int i)
+	{
+		T* ci = detail::view_row(c, i) + i;
+		int len = n - i;
+		A* sum = detail::scratch<A>(n, 0);
+		if (beta == T(0))
+			std::fill(sum, sum + len, A(0));
+		else
+		{
+			detail::convert(ci, sum, len);
+			detail::scal(static_cast<A>(beta), sum, len);
+		}
+		if (trans == transposition::none)
+		{
+			const T* ai = a.row_data(i);
+			for (int j = 0; j < len; ++j)
+				sum[j] += static_cast<A>(alpha) * detail::dot<A>(ai, a.row_data(i + j), k);
+		}
+		else
+		{
+			for (int r = 0; r < k; ++r)
+			{
+				const T* ar = a.row_data(r);
+				detail::axpy(static_cast<A>(alpha) * static_cast<A>(ar[i]), ar + i, sum, len);
+			}
+		}
+		detail::convert(sum, ci, len);
+	};
+	parallel_for(0, (n + 1) / 2, parallel_grain(static_cast<long long>(n) * k), [&](int begin, int end)
+	{
+		for (int i = begin; i < end; ++i)
+		{
+			upper_row(i);
+			if (n - 1 - i != i)
+				upper_row(n - 1 - i);
+		}
+	});
+
+	T* c0 = detail::view_row(c, 0);
+	std::ptrdiff_t ldc = c.stride();
+	parallel_for(1, n, parallel_grain(n), [&](int begin, int end)
+	{
+		for (int j = begin; j < end; ++j)
+		{
+			T* cj = c0 + j * ldc;
+			for (int i = 0; i < j; ++i)
+				cj[i] = c0[i * ldc + j];
+		}
+	});
+}
+
+namespace detail {
+
+static const int gemm_mr = 4; //!< Number of rows of micro-kernel tile
+static const int gemm_nr = 8; //!< Number of columns of micro-kernel tile
+static const int gemm_kc = 256; //!< Depth of packed panels
+static const int gemm_mc = 96; //!< Number of rows of packed block of A
+static const int gemm_nc = 2048; //!< Number of columns of packed panel of B
+
+/**
+ * \brief Packs block of op(A) into row micro-panels of gemm_mr rows
+ *
+ * Elements are converted to accumulator type A. Rows missing in the last
+ * micro-panel are filled with zeros.
+*/
+template<typename T, typename A>
+inline void gemm_pack_a(const matrix<T>& a, transposition trans, int ic, int pc, int mc, int kc, A* dst)
+{
+	A* tmp = scratch<A>(std::max(mc, kc), 0);
+	if (trans == transposition::none)
+	{
+		for (int ir = 0; ir < mc; ir += gemm_mr, dst += gemm_mr * kc)
+		{
+			int mr = std::min(gemm_mr, mc - ir);
+			for (int i = 0; i < gemm_mr; ++i)
+			{
+				const A* src = i < mr ? converted(a.row_data(ic + ir + i) + pc, kc, tmp) : nullptr;
+				for (int p = 0; p < kc; ++p)
+					dst[p * gemm_mr + i] = src ? src[p] : A(0);
+			}
+		}
+	}
+	else
+	{
+		for (int p = 0; p < kc; ++p)
+		{
+			const A* src = converted(a.row_data(pc + p) + ic, mc, tmp);
+			for (int ir = 0; ir < mc; ir += gemm_mr)
+			{
+				A* panel = dst + ir * kc + p * gemm_mr;
+				for (int i = 0; i < gemm_mr; ++i)
+					panel[i] = ir + i < mc ? src[ir + i] : A(0);
+			}
+		}
+	}
+}
+
+/**
+ * \brief Packs column micro-panels [first, last) of op(B) panel (gemm_nr columns each)
+ *
+ * Elements are converted to accumulator type A. Columns missing in the
+ * last micro-panel are filled with zeros.
+*/
+template<typename T, typename A>
+inline void gemm_pack_b(const matrix<T>& b, transposition trans, int pc, int jc, int kc, int nc, int first, int last, A* dst)
+{
+	A* tmp = scratch<A>(std::max(nc, kc), 0);
+	if (trans == transposition::none)
+	{
+		int j0 = first * gemm_nr;
+		int j1 = std::min(nc, last * gemm_nr);
+		for (int p = 0; p < kc; ++p)
+		{
+			const A* src = converted(b.row_data(pc + p) + jc + j0, j1 - j0, tmp);
+			for (int jr = j0; jr < j1; jr += gemm_nr)
+			{
+				A* panel = dst + jr * kc + p * gemm_nr;
+				for (int j = 0; j < gemm_nr; ++j)
+					panel[j] = jr + j < nc ? src[jr + j - j0] : A(0);
+			}
+		}
+	}
+	else
+	{
+		for (int jr = first * gemm_nr; jr < last * gemm_nr; jr += gemm_nr)
+		{
+			A* panel = dst + jr * kc;
+			for (int j = 0; j < gemm_nr; ++j)
+			{
+				const A* src = jr + j < nc ? converted(b.row_data(jc + jr + j) + pc, kc, tmp) : nullptr;
+				for (int p = 0; p < kc; ++p)
+					panel[p * gemm_nr + j] = src ? src[p] : A(0);
+			}
+		}
+	}
+}
+
+/**
+ * \brief Multiplies packed micro-panels and updates tile of C
+ *
+ * Calculates C = alpha * A * B + beta * C for tile of mr rows and nr columns.
+ * Accumulators are kept in small local array, so the compiler may keep them
+ * in vector registers. Rows of C stored in other type are converted with
+ * mn::detail::convert.
+*/
+template<typename A, typename T>
+inline void gemm_micro(int kc, const A* a, const A* b, A alpha, A beta, T* c, int ldc, int mr, int nr)
+{
+	A ab[gemm_mr][gemm_nr] = {};
+	for (int p = 0; p < kc; ++p, a += gemm_mr, b += gemm_nr)
+	{
+		for (int i = 0; i < gemm_mr; ++i)
+		{
+			for (int j = 0; j < gemm_nr; ++j)
+				ab[i][j] += a[i] * b[j];
+		}
+	}
+	A row[gemm_nr];
+	for (int i = 0; i < mr; ++i, c += ldc)
+	{
+		A* out = conversion_target(c, row);
+		if (beta == A(0))
+		{
+			for (int j = 0; j < nr; ++j)
+				out[j] = alpha * ab[i][j];
+		}
+		else
+		{
+			const A* old = converted(c, nr, row);
+			for (int j = 0; j < nr; ++j)
+				out[j] = beta * old[j] + alpha * ab[i][j];
+		}
+		store_converted(out, c, nr);
+	}
+}
+
+}
+
+/**
+ * \brief Multiplies two matrices and accumulates result (C = alpha * op(A) * op(B) + beta * C)
+ *
+ * Writes product directly into existing matrix C, which may be submatrix
+ * of other matrix. op(X) is X or its transposition, according to trans_a
+ * and trans_b flags. Operands are multiplied block by block: panels of
+ * op(B) and blocks of op(A) are packed into thread-local buffers, which
+ * are reused by subsequent calls, so no other memory is allocated. Blocks
+ * of rows of C are computed in parallel. If beta is zero, C does not have
+ * to be initialized. C must not share memory with A or B.
+ *
+ * Operands are converted to accumulator type A while being packed, so
+ * matrices of reduced precision types (e.g. mn::bfloat16) are multiplied
+ * in float, and float matrices may be multiplied in double by calling
+ * mn::gemm<float, double>(...).
+ *
+ * Every element of C is accumulated by single thread in order fixed by
+ * block sizes, which do not depend on number of threads, so results are
+ * bitwise reproducible for any number of threads.
+ *
+ * \param alpha Scaling factor of product
+ * \param a Matrix A
+ * \param b Matrix B
+ * \param beta Scaling factor of C
+ * \param c Matrix C (result)
+ * \param trans_a Transposition of A
+ * \param trans_b Transposition of B
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline void gemm(const typename matrix<T>::value_type& alpha, const matrix<T>& a, const matrix<T>& b,
+	const typename matrix<T>::value_type& beta, matrix<T>& c,
+	transposition trans_a = transposition::none, transposition trans_b = transposition::none)
+{
+	int m = trans_a == transposition::none ? a.rows() : a.cols();
+	int k = trans_a == transposition::none ? a.cols() : a.rows();
+	int n = trans_b == transposition::none ? b.cols() : b.rows();
+	int kb = trans_b == transposition::none ? b.rows() : b.cols();
+	if (k != kb || c.rows() != m || c.cols() != n)
+		throw matrix_exception("dimensions mismatch");
+	c.detach();
+	if (k == 0)
+	{
+		for (int i = 0; i < m; ++i)
+			detail::scal(beta, detail::view_row(c, i), n);
+		return;
+	}
+
+	int mc = detail::gemm_mc;
+	int threads = get_num_threads();
+	if (static_cast<long long>(m) * n * k < parallel_min_work * 16LL)
+		threads = 1;
+	if (m < mc * threads)
+		mc = std::max(detail::gemm_mr, (m / threads + detail::gemm_mr - 1) / detail::gemm_mr * detail::gemm_mr);
+	int blocks = (m + mc - 1) / mc;
+	int ldc = c.stride();
+
+	// When C is stored in other type than accumulator, whole depth is packed at once,
+	// so partial sums are never rounded to storage type
+	int kc_max = detail::gemm_kc;
+	int nc_max = detail::gemm_nc;
+	if (!std::is_same<T, A>::value && k > kc_max)
+	{
+		nc_max = std::max(detail::gemm_nr, static_cast<int>(static_cast<long long>(kc_max) * nc_max / k) / detail::gemm_nr * detail::gemm_nr);
+		kc_max = k;
+	}
+
+	for (int jc = 0; jc < n; jc += nc_max)
+	{
+		int nc = std::min(nc_max, n - jc);
+		int panels = (nc + detail::gemm_nr - 1) / detail::gemm_nr;
+		for (int pc = 0; pc < k; pc += kc_max)
+		{
+			int kc = std::min(kc_max, k - pc);
+			A beta_block = pc == 0 ? static_cast<A>(beta) : A(1);
+			A* packed_b = detail::scratch<A>(static_cast<std::size_t>(panels) * detail::gemm_nr * kc, 1);
+			parallel_for(0, panels, threads > 1 ? parallel_grain(detail::gemm_nr * kc) : panels, [&](int begin, int end)
+			{
+				detail::gemm_pack_b(b, trans_b, pc, jc, kc, nc, begin, end, packed_b);
+			});
+			parallel_for(0, blocks, threads > 1 ? 1 : blocks, [&](int begin, int end)
+			{
+				A* packed_a = detail::scratch<A>(static_cast<std::size_t>(mc + detail::gemm_mr) * kc, 2);
+				for (int block = begin; block < end; ++block)
+				{
+					int ic = block * mc;
+					int mb = std::min(mc, m - ic);
+					detail::gemm_pack_a(a, trans_a, ic, pc, mb, kc, packed_a);
+					for (int jr = 0; jr < nc; jr += detail::gemm_nr)
+					{
+						for (int ir = 0; ir < mb; ir += detail::gemm_mr)
+						{
+							detail::gemm_micro(kc, packed_a + ir * kc, packed_b + jr * kc, static_cast<A>(alpha), beta_block,
+								detail::view_row(c, ic + ir) + jc + jr, ldc, std::min(detail::gemm_mr, mb - ir), std::min(detail::gemm_nr, nc - jr));
+						}
+					}
+				}
+			});
+		}
+	}
+}
+
+
+namespace detail {
+
+/**
+ * \brief Returns row-major matrix holding elements of row-major matrix (matrix itself)
+*/
+template<typename T>
+inline matrix<T>& storage(matrix<T>& m)
+{
+	return m;
+}
+
+/**
+ * \brief Returns row-major matrix holding elements of constant row-major matrix (matrix itself)
+*/
+template<typename T>
+inline const matrix<T>& storage(const matrix<T>& m)
+{
+	return m;
+}
+
+/**
+ * \brief Returns row-major matrix holding transposition of column-major matrix
+*/
+template<typename T>
+inline matrix<T>& storage(matrix<T, layout::col_major>& m)
+{
+	return m.storage();
+}
+
+/**
+ * \brief Returns row-major matrix holding transposition of constant column-major matrix
+*/
+template<typename T>
+inline const matrix<T>& storage(const matrix<T, layout::col_major>& m)
+{
+	return m.storage();
+}
+
+/**
+ * \brief Returns transposition of row-major storage of operand op(X) stored in layout L
+ *
+ * Storage of column-major matrix is its transposition, so flag is flipped.
+*/
+inline transposition stored(transposition trans, layout order)
+{
+	bool flipped = (trans == transposition::transposed) != (order == layout::col_major);
+	return flipped ? transposition::transposed : transposition::none;
+}
+
+/**
+ * \brief Returns opposite transposition flag
+*/
+inline transposition flip(transposition trans)
+{
+	return trans == transposition::none ? transposition::transposed : transposition::none;
+}
+
+}
+
+/**
+ * \brief Multiplies matrices stored in any layout (C = alpha * op(A) * op(B) + beta * C)
+ *
+ * Column-major operands are passed to row-major mn::gemm as transposed
+ * storage. Column-major C is computed as C^T = op(B)^T * op(A)^T, so no
+ * operand is ever copied to change its layout.
+ *
+ * \param alpha Scaling factor of product
+ * \param a Matrix A
+ * \param b Matrix B
+ * \param beta Scaling factor of C
+ * \param c Matrix C (result)
+ * \param trans_a Transposition of A
+ * \param trans_b Transposition of B
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>, layout LA, layout LB, layout LC>
+inline void gemm(const typename matrix<T>::value_type& alpha, const matrix<T, LA>& a, const matrix<T, LB>& b, const typename matrix<T>::value_type& beta, matrix<T, LC>& c,
+	transposition trans_a = transposition::none, transposition trans_b = transposition::none)
+{
+	transposition ta = detail::stored(trans_a, LA), tb = detail::stored(trans_b, LB);
+	if (LC == layout::row_major)
+		gemm<T, A>(alpha, detail::storage(a), detail::storage(b), beta, detail::storage(c), ta, tb);
+	else
+		gemm<T, A>(alpha, detail::storage(b), detail::storage(a), beta, detail::storage(c), detail::flip(tb), detail::flip(ta));
+}
+
+/**
+ * \brief Multiplies matrix stored in any layout by vector (y = alpha * op(A) * x + beta * y)
+ *
+ * Column-major A is passed to row-major mn::gemv as transposed storage.
+ * Vectors may be of any layout too, as order of their elements is the same.
+ *
+ * \param alpha Scaling factor of product
+ * \param a Matrix A
+ * \param x Vector x
+ * \param beta Scaling factor of y
+ * \param y Vector y (result)
+ * \param trans Transposition of A
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>, layout LA, layout LX, layout LY>
+inline void gemv(const typename matrix<T>::value_type& alpha, const matrix<T, LA>& a, const matrix<T, LX>& x, const typename matrix<T>::value_type& beta, matrix<T, LY>& y,
+	transposition trans = transposition::none)
+{
+	gemv<T, A>(alpha, detail::storage(a), detail::storage(x), beta, detail::storage(y), detail::stored(trans, LA));
+}
+
+/**
+ * \brief Performs symmetric rank-k update of matrices stored in any layout
+ *
+ * C is symmetric, so its storage is updated directly in both layouts.
+ *
+ * \param alpha Scaling factor of product
+ * \param a Matrix A
+ * \param beta Scaling factor of C
+ * \param c Square matrix C (result)
+ * \param trans Transposition of A
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>, layout LA, layout LC>
+inline void syrk(const typename matrix<T>::value_type& alpha, const matrix<T, LA>& a, const typename matrix<T>::value_type& beta, matrix<T, LC>& c, transposition trans = transposition::none)
+{
+	syrk<T, A>(alpha, detail::storage(a), beta, detail::storage(c), detail::stored(trans, LA));
+}
+
+/**
+ * \brief Performs rank-1 update of matrix stored in any layout (A = alpha * x * y^T + A)
+ *
+ * Storage of column-major A is updated as A^T = alpha * y * x^T + A^T.
+ *
+ * \param alpha Scaling factor of update
+ * \param x Vector x
+ * \param y Vector y
+ * \param a Matrix A (result)
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>, layout LX, layout LY, layout LA>
+inline void ger(const typename matrix<T>::value_type& alpha, const matrix<T, LX>& x, const matrix<T, LY>& y, matrix<T, LA>& a)
+{
+	if (LA == layout::row_major)
+		ger<T, A>(alpha, detail::storage(x), detail::storage(y), detail::storage(a));
+	else
+		ger<T, A>(alpha, detail::storage(y), detail::storage(x), detail::storage(a));
+}
+
+}
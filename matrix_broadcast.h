@@ -0,0 +1,176 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <functional>
+
+#include "matrix_exception.h"
+#include "matrix_parallel.h"
+
+namespace mn {
+
+/**
+ * \brief Combines matrix with row or column vector repeated along it (result = op(m, v))
+ *
+ * If v is row vector with cols() elements, op is applied to every row of m
+ * and v. If v is column vector with rows() elements, op is applied to every
+ * column of m and v. Repeated vector is never materialized: m is streamed
+ * once, row by row, so simple operations are vectorized by compiler. Rows
+ * are processed in parallel. Result may be m itself (operation in place);
+ * all matrices may be submatrices, but v must not share memory with result.
+ *
+ * \param m Matrix
+ * \param v Row or column vector
+ * \param result Matrix of the same size as m (result)
+ * \param op Function called as op(element of m, element of v)
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename F>
+inline void broadcast(const matrix<T>& m, const matrix<T>& v, matrix<T>& result, F op)
+{
+	int rows = m.rows(), cols = m.cols();
+	if (result.rows() != rows || result.cols() != cols)
+		throw matrix_exception("dimensions mismatch");
+	result.detach();
+	if (v.rows() == 1 && v.cols() == cols)
+	{
+		const T* vp = v.row_data(0);
+		parallel_for(0, rows, parallel_grain(cols), [&](int begin, int end)
+		{
+			for (int r = begin; r < end; ++r)
+			{
+				const T* x = m.row_data(r);
+				T* y = result.row_data(r);
+				for (int c = 0; c < cols; ++c)
+					y[c] = op(x[c], vp[c]);
+			}
+		});
+	}
+	else if (v.cols() == 1 && v.rows() == rows)
+	{
+		parallel_for(0, rows, parallel_grain(cols), [&](int begin, int end)
+		{
+			for (int r = begin; r < end; ++r)
+			{
+				const T* x = m.row_data(r);
+				T* y = result.row_data(r);
+				const T value = *v.row_data(r);
+				for (int c = 0; c < cols; ++c)
+					y[c] = op(x[c], value);
+			}
+		});
+	}
+	else
+		throw matrix_exception("dimensions mismatch");
+}
+
+/**
+ * \brief Combines matrix with row or column vector repeated along it
+ *
+ * Allocates new matrix containing op(m, v), see mn::broadcast(m, v, result, op).
+ *
+ * \param m Matrix
+ * \param v Row or column vector
+ * \param op Function called as op(element of m, element of v)
+ * \return New matrix containing result
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename F>
+inline matrix<T> broadcast(const matrix<T>& m, const matrix<T>& v, F op)
+{
+	matrix<T> result(m.rows(), m.cols());
+	broadcast(m, v, result, op);
+	return result;
+}
+
+/**
+ * \brief Adds row vector to every row of matrix
+ *
+ * \param m Matrix (modified in place)
+ * \param v Row vector with m.cols() elements
+ * \return Reference to modified matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T>& add_row_vector(matrix<T>& m, const matrix<T>& v)
+{
+	if (v.rows() != 1)
+		throw matrix_exception("not a row vector");
+	broadcast(m, v, m, std::plus<T>());
+	return m;
+}
+
+/**
+ * \brief Multiplies every row of matrix by row vector element by element
+ *
+ * Scales every column of matrix by corresponding element of vector.
+ *
+ * \param m Matrix (modified in place)
+ * \param v Row vector with m.cols() elements
+ * \return Reference to modified matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T>& mul_row_vector(matrix<T>& m, const matrix<T>& v)
+{
+	if (v.rows() != 1)
+		throw matrix_exception("not a row vector");
+	broadcast(m, v, m, std::multiplies<T>());
+	return m;
+}
+
+/**
+ * \brief Adds column vector to every column of matrix
+ *
+ * \param m Matrix (modified in place)
+ * \param v Column vector with m.rows() elements
+ * \return Reference to modified matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T>& add_col_vector(matrix<T>& m, const matrix<T>& v)
+{
+	if (v.cols() != 1)
+		throw matrix_exception("not a column vector");
+	broadcast(m, v, m, std::plus<T>());
+	return m;
+}
+
+/**
+ * \brief Multiplies every column of matrix by column vector element by element
+ *
+ * Scales every row of matrix by corresponding element of vector.
+ *
+ * \param m Matrix (modified in place)
+ * \param v Column vector with m.rows() elements
+ * \return Reference to modified matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T>& mul_col_vector(matrix<T>& m, const matrix<T>& v)
+{
+	if (v.cols() != 1)
+		throw matrix_exception("not a column vector");
+	broadcast(m, v, m, std::multiplies<T>());
+	return m;
+}
+
+}
@@ -0,0 +1,238 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#include "matrix_exception.h"
+#include "matrix_parallel.h"
+#include "matrix_precision.h"
+#include "matrix_reductions.h"
+
+namespace mn {
+
+/**
+ * \brief Type in which elements of type T are compared approximately
+ *
+ * Floating point elements are compared in their accumulator type, integers
+ * in double precision, so that differences never overflow.
+*/
+template<typename T>
+using comparison_t = typename std::conditional<std::is_floating_point<accumulator_t<T>>::value, accumulator_t<T>, double>::type;
+
+namespace detail {
+
+/**
+ * \brief Number of elements compared between checks for early exit
+*/
+const int compare_chunk = 256;
+
+/**
+ * \brief Checks predicate for every row of matrix in parallel
+ *
+ * Stops all threads as soon as predicate fails for any row.
+*/
+template<typename F>
+inline bool all_rows(int rows, int cols, F pred)
+{
+	std::atomic<bool> failed(false);
+	parallel_for(0, rows, parallel_grain(cols), [&](int begin, int end)
+	{
+		for (int r = begin; r < end && !failed.load(std::memory_order_relaxed); ++r)
+		{
+			if (!pred(r))
+				failed.store(true, std::memory_order_relaxed);
+		}
+	});
+	return !failed.load();
+}
+
+/**
+ * \brief Compares contiguous arrays of integers (uses memcmp)
+*/
+template<typename T>
+inline bool equal_row(const T* x, const T* y, int n, std::true_type)
+{
+	return std::memcmp(x, y, n * sizeof(T)) == 0;
+}
+
+/**
+ * \brief Compares contiguous arrays with operator== of accumulator type
+ *
+ * Keeps semantics of floating point comparison (0 == -0, NaN != NaN).
+ * Every chunk is compared without branches, so it may be vectorized.
+*/
+template<typename T>
+inline bool equal_row(const T* x, const T* y, int n, std::false_type)
+{
+	typedef accumulator_t<T> A;
+	A xs[compare_chunk], ys[compare_chunk];
+	for (int i = 0; i < n; i += compare_chunk)
+	{
+		int len = std::min(compare_chunk, n - i);
+		const A* a = converted(x + i, len, xs);
+		const A* b = converted(y + i, len, ys);
+		int diff = 0;
+		for (int j = 0; j < len; ++j)
+			diff |= a[j] != b[j];
+		if (diff)
+			return false;
+	}
+	return true;
+}
+
+}
+
+/**
+ * \brief Compares two matrices
+ *
+ * Returns true if two matrices are equal (are of the same size and contain the same elements).
+ * Rows are compared in parallel with memcmp for integer types and with
+ * vectorizable loops for other ones; comparison stops at first difference.
+ *
+ * \param m Second matrix to compare
+ * \return True if equal
+*/
+template<typename T>
+inline bool matrix<T>::operator==(const matrix<T>& m) const
+{
+	if (rows() != m.rows() || cols() != m.cols())
+		return false;
+	int n = cols();
+	return detail::all_rows(rows(), n, [&](int r)
+	{
+		return detail::equal_row(row_data(r), m.row_data(r), n, std::is_integral<T>());
+	});
+}
+
+/**
+ * \brief Compares two matrices if they are not equal
+ *
+ * Returns true if two matrices are not equal (are of different size or contain different elements).
+ *
+ * \param m Second matrix to compare
+ * \return True if not equal
+*/
+template<typename T>
+inline bool matrix<T>::operator!=(const matrix<T>& m) const
+{
+	return !operator==(m);
+}
+
+/**
+ * \brief Checks if two matrices are equal within tolerance
+ *
+ * Returns true if matrices are of the same size and for every pair of
+ * corresponding elements |a - b| <= atol + rtol * |b|. NaN elements are never
+ * close. Rows are compared in parallel with vectorizable loops and
+ * comparison stops at first element out of tolerance.
+ *
+ * \param a Matrix A
+ * \param b Matrix B (reference)
+ * \param rtol Relative tolerance
+ * \param atol Absolute tolerance
+ * \return True if all elements are close
+*/
+template<typename T>
+inline bool allclose(const matrix<T>& a, const matrix<T>& b, double rtol = 1e-5, double atol = 1e-8)
+{
+	typedef comparison_t<T> C;
+	if (a.rows() != b.rows() || a.cols() != b.cols())
+		return false;
+	int n = a.cols();
+	const C rt = static_cast<C>(rtol), at = static_cast<C>(atol);
+	return detail::all_rows(a.rows(), n, [&](int r)
+	{
+		C xs[detail::compare_chunk], ys[detail::compare_chunk];
+		const T* x = a.row_data(r);
+		const T* y = b.row_data(r);
+		for (int i = 0; i < n; i += detail::compare_chunk)
+		{
+			int len = std::min(detail::compare_chunk, n - i);
+			const C* p = detail::converted(x + i, len, xs);
+			const C* q = detail::converted(y + i, len, ys);
+			int far = 0;
+			for (int j = 0; j < len; ++j)
+				far |= !(detail::absolute(p[j] - q[j]) <= at + rt * detail::absolute(q[j]));
+			if (far)
+				return false;
+		}
+		return true;
+	});
+}
+
+/**
+ * \brief Returns maximal absolute difference of corresponding elements
+ *
+ * Rows are processed in parallel with vectorizable loops. If any difference
+ * is NaN, NaN is returned as soon as it is found.
+ *
+ * \param a Matrix A
+ * \param b Matrix B
+ * \return max |a - b|
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline comparison_t<T> max_abs_diff(const matrix<T>& a, const matrix<T>& b)
+{
+	typedef comparison_t<T> C;
+	if (a.rows() != b.rows() || a.cols() != b.cols())
+		throw matrix_exception("dimensions mismatch");
+	int n = a.cols();
+	std::atomic<bool> found_nan(false);
+	return detail::reduce_blocks<C>(a.rows(), parallel_grain(n), [&](int begin, int end)
+	{
+		C xs[detail::compare_chunk], ys[detail::compare_chunk];
+		C m = C(0);
+		for (int r = begin; r < end; ++r)
+		{
+			const T* x = a.row_data(r);
+			const T* y = b.row_data(r);
+			for (int i = 0; i < n; i += detail::compare_chunk)
+			{
+				if (found_nan.load(std::memory_order_relaxed))
+					return m;
+				int len = std::min(detail::compare_chunk, n - i);
+				const C* p = detail::converted(x + i, len, xs);
+				const C* q = detail::converted(y + i, len, ys);
+				int nan = 0;
+				for (int j = 0; j < len; ++j)
+				{
+					C d = detail::absolute(p[j] - q[j]);
+					nan |= d != d;
+					m = d > m ? d : m;
+				}
+				if (nan)
+				{
+					found_nan.store(true, std::memory_order_relaxed);
+					return std::numeric_limits<C>::quiet_NaN();
+				}
+			}
+		}
+		return m;
+	}, [](C x, C y) { return x != x ? x : (y > x || y != y ? y : x); }, summation::fast);
+}
+
+}
@@ -0,0 +1,324 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <vector>
+
+#include "matrix_exception.h"
+#include "matrix_parallel.h"
+
+namespace mn {
+
+namespace detail {
+
+/**
+ * \brief Returns writable pointer to row of matrix without detaching it
+ *
+ * Used by kernels writing rows in parallel after destination was detached.
+*/
+template<typename T>
+inline T* view_row(const matrix<T>& m, int index)
+{
+	return const_cast<T*>(m.row_data(index));
+}
+
+}
+
+/**
+ * \brief Concatenates matrices horizontally
+ *
+ * Allocates new matrix once and copies every row of every block with single
+ * bulk copy (memmove for trivially copyable types). Number of rows of result
+ * equals the largest number of rows of blocks, missing values are initialized
+ * to zeros. Rows of result are filled in parallel.
+ *
+ * \param blocks Matrices to concatenate (left to right)
+ * \return New matrix containing concatenated blocks
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> hconcat(const std::vector<matrix<T>>& blocks)
+{
+	if (blocks.empty())
+		throw matrix_exception("nothing to concatenate");
+	int rows_n = 0;
+	long long cols_n = 0;
+	for (const matrix<T>& b : blocks)
+	{
+		rows_n = std::max(rows_n, b.rows());
+		cols_n += b.cols();
+	}
+	if (cols_n > std::numeric_limits<int>::max())
+		throw matrix_exception("matrix too large");
+	matrix<T> result(rows_n, static_cast<int>(cols_n));
+	parallel_for(0, rows_n, parallel_grain(cols_n), [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+		{
+			T* dst = result.row_data(r);
+			for (const matrix<T>& b : blocks)
+			{
+				if (r < b.rows())
+					std::copy(b.row_data(r), b.row_data(r) + b.cols(), dst);
+				else
+					std::fill(dst, dst + b.cols(), T(0));
+				dst += b.cols();
+			}
+		}
+	});
+	return result;
+}
+
+/**
+ * \brief Concatenates matrices horizontally
+ *
+ * \param blocks Matrices to concatenate (left to right)
+ * \return New matrix containing concatenated blocks
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> hconcat(std::initializer_list<matrix<T>> blocks)
+{
+	return hconcat(std::vector<matrix<T>>(blocks));
+}
+
+/**
+ * \brief Concatenates matrices vertically
+ *
+ * Allocates new matrix once and copies every row of every block with single
+ * bulk copy (memmove for trivially copyable types). Number of columns of
+ * result equals the largest number of columns of blocks, missing values are
+ * initialized to zeros. Rows of every block are copied in parallel.
+ *
+ * \param blocks Matrices to concatenate (top to bottom)
+ * \return New matrix containing concatenated blocks
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> vconcat(const std::vector<matrix<T>>& blocks)
+{
+	if (blocks.empty())
+		throw matrix_exception("nothing to concatenate");
+	long long rows_n = 0;
+	int cols_n = 0;
+	for (const matrix<T>& b : blocks)
+	{
+		rows_n += b.rows();
+		cols_n = std::max(cols_n, b.cols());
+	}
+	if (rows_n > std::numeric_limits<int>::max())
+		throw matrix_exception("matrix too large");
+	matrix<T> result(static_cast<int>(rows_n), cols_n);
+	int offset = 0;
+	for (const matrix<T>& b : blocks)
+	{
+		int cols = b.cols();
+		parallel_for(0, b.rows(), parallel_grain(cols_n), [&](int begin, int end)
+		{
+			for (int r = begin; r < end; ++r)
+			{
+				T* dst = result.row_data(offset + r);
+				std::copy(b.row_data(r), b.row_data(r) + cols, dst);
+				std::fill(dst + cols, dst + cols_n, T(0));
+			}
+		});
+		offset += b.rows();
+	}
+	return result;
+}
+
+/**
+ * \brief Concatenates matrices vertically
+ *
+ * \param blocks Matrices to concatenate (top to bottom)
+ * \return New matrix containing concatenated blocks
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> vconcat(std::initializer_list<matrix<T>> blocks)
+{
+	return vconcat(std::vector<matrix<T>>(blocks));
+}
+
+/**
+ * \brief Copies elements of one matrix to another one of the same size
+ *
+ * Both matrices may be submatrices (views), e.g. assign(m.submatrix(0, 9, 0, 9), block).
+ * Every row is copied with single bulk copy (memmove for trivially copyable
+ * types), rows of large blocks are copied in parallel. If both views point
+ * to overlapping memory, rows are copied by single thread in order which
+ * never overwrites elements that are not copied yet, so result equals a
+ * copy made through temporary matrix.
+ *
+ * Copy-on-write destination is detached first (see mn::matrix::detach).
+ *
+ * \param src Source matrix
+ * \param dst Destination matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void copy_block(const matrix<T>& src, matrix<T>& dst)
+{
+	dst.detach();
+	int rows = src.rows(), cols = src.cols();
+	if (dst.rows() != rows || dst.cols() != cols)
+		throw matrix_exception("dimensions mismatch");
+	if (rows == 0 || cols == 0)
+		return;
+	const T* src_first = src.row_data(0);
+	const T* src_last = src.row_data(rows - 1) + cols;
+	const T* dst_first = detail::view_row(dst, 0);
+	const T* dst_last = detail::view_row(dst, rows - 1) + cols;
+	if (std::less<const T*>()(src_first, dst_last) && std::less<const T*>()(dst_first, src_last))
+	{
+		if (std::less<const T*>()(dst_first, src_first))
+		{
+			for (int r = 0; r < rows; ++r)
+				std::copy(src.row_data(r), src.row_data(r) + cols, detail::view_row(dst, r));
+		}
+		else
+		{
+			for (int r = rows - 1; r >= 0; --r)
+				std::copy_backward(src.row_data(r), src.row_data(r) + cols, detail::view_row(dst, r) + cols);
+		}
+		return;
+	}
+	parallel_for(0, rows, parallel_grain(cols), [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+			std::copy(src.row_data(r), src.row_data(r) + cols, detail::view_row(dst, r));
+	});
+}
+
+/**
+ * \brief Copies elements of one matrix to temporary view of the same size
+ *
+ * Allows to pass submatrix directly, e.g. copy_block(block, m.submatrix(0, 9, 0, 9)).
+ *
+ * \param src Source matrix
+ * \param dst Destination view
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void copy_block(const matrix<T>& src, matrix<T>&& dst)
+{
+	copy_block(src, dst);
+}
+
+/**
+ * \brief Copies matrix into region of another matrix
+ *
+ * Region starts at given position and has the size of source matrix.
+ * Works like mn::copy_block(src, dst).
+ *
+ * \param src Source matrix
+ * \param dst Destination matrix
+ * \param row First row of region in destination matrix
+ * \param col First column of region in destination matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void copy_block(const matrix<T>& src, matrix<T>& dst, int row, int col)
+{
+	copy_block(src, dst.view(row, row + src.rows() - 1, col, col + src.cols() - 1));
+}
+
+/**
+ * \brief Copies matrix into region of temporary view
+ *
+ * \param src Source matrix
+ * \param dst Destination view
+ * \param row First row of region in destination view
+ * \param col First column of region in destination view
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void copy_block(const matrix<T>& src, matrix<T>&& dst, int row, int col)
+{
+	copy_block(src, dst, row, col);
+}
+
+/**
+ * \brief Assigns elements of matrix to view of the same size
+ *
+ * Works like mn::copy_block(src, dst), e.g.
+ * mn::assign(m.submatrix(0, 1, 0, 1), block).
+ *
+ * \param dst Destination matrix
+ * \param src Source matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void assign(matrix<T>& dst, const matrix<T>& src)
+{
+	copy_block(src, dst);
+}
+
+/**
+ * \brief Assigns elements of matrix to temporary view of the same size
+ *
+ * \param dst Destination view
+ * \param src Source matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void assign(matrix<T>&& dst, const matrix<T>& src)
+{
+	copy_block(src, dst);
+}
+
+/**
+ * \brief Copies matrix and appends another one horizontally
+ *
+ * This method creates and allocates new matrix, copies original matrix
+ * to it, and appends second matrix (passed as an argument) horizontally.
+ * If numbers of rows don't match, empty values are initialized to zeros.
+ *
+ * \param m Matrix to append to original
+ * \return mn::matrix
+*/
+template<typename T>
+inline matrix<T> matrix<T>::append_h(const matrix<T>& m) const
+{
+	return hconcat({ *this, m });
+}
+
+/**
+ * \brief Copies matrix and appends another one vertically
+ *
+ * This method creates and allocates new matrix, copies original matrix
+ * to it, and appends second matrix (passed as an argument) vertically.
+ * If numbers of columns don't match, empty values are initialized to zeros.
+ *
+ * \param m Matrix to append to original
+ * \return mn::matrix
+*/
+template<typename T>
+inline matrix<T> matrix<T>::append_v(const matrix<T>& m) const
+{
+	return vconcat({ *this, m });
+}
+
+}
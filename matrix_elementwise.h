@@ -0,0 +1,335 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+
+#include "matrix_exception.h"
+#include "matrix_parallel.h"
+#include "matrix_precision.h"
+
+namespace mn {
+
+namespace detail {
+
+/**
+ * \brief Applies function to every element of matrix (z = f(x))
+ *
+ * Function is called with elements converted to accumulator type (see
+ * mn::accumulator). Reduced precision elements are converted in chunks
+ * with vector conversion instructions, results are converted back the same
+ * way. Rows are processed in parallel. Matrix z may be the operand.
+*/
+template<typename T, typename F>
+inline void apply(const matrix<T>& x, matrix<T>& z, F f)
+{
+	typedef accumulator_t<T> A;
+	// Shared copy-on-write block has to be copied before rows are written by many threads
+	z.detach();
+	int cols = z.cols();
+	int chunk = convert_chunk_size<T, A>(cols);
+	parallel_for(0, z.rows(), parallel_grain(cols), [&](int begin, int end)
+	{
+		A xs[convert_chunk], zs[convert_chunk];
+		for (int r = begin; r < end; ++r)
+		{
+			const T* xr = x.row_data(r);
+			T* zr = view_row(z, r);
+			for (int i = 0; i < cols; i += chunk)
+			{
+				int len = std::min(chunk, cols - i);
+				const A* xa = converted(xr + i, len, xs);
+				A* za = conversion_target(zr + i, zs);
+				for (int c = 0; c < len; ++c)
+					za[c] = f(xa[c]);
+				store_converted(za, zr + i, len);
+			}
+		}
+	});
+}
+
+/**
+ * \brief Combines two matrices element by element (z = f(x, y))
+ *
+ * Elements are passed to function in accumulator type, like in
+ * mn::detail::apply. Rows are processed in parallel. Matrix z may be one
+ * of the operands.
+*/
+template<typename T, typename F>
+inline void combine(const matrix<T>& x, const matrix<T>& y, matrix<T>& z, F f)
+{
+	typedef accumulator_t<T> A;
+	// Shared copy-on-write block has to be copied before rows are written by many threads
+	z.detach();
+	int cols = z.cols();
+	int chunk = convert_chunk_size<T, A>(cols);
+	parallel_for(0, z.rows(), parallel_grain(cols), [&](int begin, int end)
+	{
+		A xs[convert_chunk], ys[convert_chunk], zs[convert_chunk];
+		for (int r = begin; r < end; ++r)
+		{
+			const T* xr = x.row_data(r);
+			const T* yr = y.row_data(r);
+			T* zr = view_row(z, r);
+			for (int i = 0; i < cols; i += chunk)
+			{
+				int len = std::min(chunk, cols - i);
+				const A* xa = converted(xr + i, len, xs);
+				const A* ya = converted(yr + i, len, ys);
+				A* za = conversion_target(zr + i, zs);
+				for (int c = 0; c < len; ++c)
+					za[c] = f(xa[c], ya[c]);
+				store_converted(za, zr + i, len);
+			}
+		}
+	});
+}
+
+/**
+ * \brief Throws exception if matrices are of different size
+ *
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void require_same_size(const matrix<T>& a, const matrix<T>& b)
+{
+	if (a.rows() != b.rows() || a.cols() != b.cols())
+		throw matrix_exception("dimensions mismatch");
+}
+
+}
+
+/**
+ * \brief Applies function to every element of matrix
+ *
+ * Allocates new matrix containing f(x) for every element x. Elements are
+ * processed row by row over contiguous arrays (see mn::detail::apply), so
+ * the compiler may vectorize simple functions; rows of large matrices are
+ * processed in parallel. Function is called with elements converted to
+ * accumulator type (float for reduced precision types) and must be safe to
+ * call from several threads.
+ *
+ * \param f Function called as f(element)
+ * \return New matrix containing results
+*/
+template<typename T>
+template<typename F>
+inline matrix<T> matrix<T>::map(F f) const
+{
+	matrix<T> result(rows(), cols());
+	detail::apply(*this, result, f);
+	return result;
+}
+
+/**
+ * \brief Applies function to corresponding elements of two matrices
+ *
+ * Allocates new matrix containing f(x, y) for every element x of current
+ * matrix and corresponding element y of second one. Processed like
+ * mn::matrix::map.
+ *
+ * \param m Second matrix
+ * \param f Function called as f(element, element of m)
+ * \return New matrix containing results
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+template<typename F>
+inline matrix<T> matrix<T>::zip_with(const matrix<T>& m, F f) const
+{
+	detail::require_same_size(*this, m);
+	matrix<T> result(rows(), cols());
+	detail::combine(*this, m, result, f);
+	return result;
+}
+
+/**
+ * \brief Replaces every element of matrix with result of function
+ *
+ * Works in place, without allocating memory. Processed like mn::matrix::map.
+ *
+ * \param f Function called as f(element)
+ * \return Reference to modified matrix
+*/
+template<typename T>
+template<typename F>
+inline matrix<T>& matrix<T>::transform(F f)
+{
+	detail::apply(*this, *this, f);
+	return *this;
+}
+
+/**
+ * \brief Replaces every element of matrix with result of function of it and corresponding element of another matrix
+ *
+ * Works in place, without allocating memory. Processed like mn::matrix::map.
+ *
+ * \param m Second matrix
+ * \param f Function called as f(element, element of m)
+ * \return Reference to modified matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+template<typename F>
+inline matrix<T>& matrix<T>::transform(const matrix<T>& m, F f)
+{
+	detail::require_same_size(*this, m);
+	detail::combine(*this, m, *this, f);
+	return *this;
+}
+
+/**
+ * \brief Multiplies matrices element by element (Hadamard product)
+ *
+ * Calculates result = a .* b. Rows are processed in parallel with
+ * vectorizable loops. Result may be one of the operands (operation in place).
+ *
+ * \param a Matrix A
+ * \param b Matrix B
+ * \param result Matrix of the same size (result)
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void hadamard(const matrix<T>& a, const matrix<T>& b, matrix<T>& result)
+{
+	detail::require_same_size(a, b);
+	detail::require_same_size(a, result);
+	typedef accumulator_t<T> A;
+	detail::combine(a, b, result, [](A x, A y) { return x * y; });
+}
+
+/**
+ * \brief Multiplies matrices element by element (Hadamard product)
+ *
+ * \param a Matrix A
+ * \param b Matrix B
+ * \return New matrix containing product
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> hadamard(const matrix<T>& a, const matrix<T>& b)
+{
+	matrix<T> result(a.rows(), a.cols());
+	hadamard(a, b, result);
+	return result;
+}
+
+/**
+ * \brief Divides matrices element by element
+ *
+ * Calculates result = a ./ b. Division by zero follows semantics of type T.
+ * Result may be one of the operands (operation in place).
+ *
+ * \param a Matrix A (dividends)
+ * \param b Matrix B (divisors)
+ * \param result Matrix of the same size (result)
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void elementwise_div(const matrix<T>& a, const matrix<T>& b, matrix<T>& result)
+{
+	detail::require_same_size(a, b);
+	detail::require_same_size(a, result);
+	typedef accumulator_t<T> A;
+	detail::combine(a, b, result, [](A x, A y) { return x / y; });
+}
+
+/**
+ * \brief Divides matrices element by element
+ *
+ * \param a Matrix A (dividends)
+ * \param b Matrix B (divisors)
+ * \return New matrix containing quotients
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> elementwise_div(const matrix<T>& a, const matrix<T>& b)
+{
+	matrix<T> result(a.rows(), a.cols());
+	elementwise_div(a, b, result);
+	return result;
+}
+
+/**
+ * \brief Multiplies matrices element by element and adds third one
+ *
+ * Calculates result = a .* b + c in single pass, without temporary matrix.
+ * Compiler may use fused multiply-add instructions when allowed to contract
+ * expressions. Result may be one of the operands (operation in place).
+ *
+ * \param a Matrix A
+ * \param b Matrix B
+ * \param c Matrix C
+ * \param result Matrix of the same size (result)
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void fma(const matrix<T>& a, const matrix<T>& b, const matrix<T>& c, matrix<T>& result)
+{
+	detail::require_same_size(a, b);
+	detail::require_same_size(a, c);
+	detail::require_same_size(a, result);
+	typedef accumulator_t<T> A;
+	result.detach();
+	int cols = a.cols();
+	int chunk = detail::convert_chunk_size<T, A>(cols);
+	parallel_for(0, a.rows(), parallel_grain(cols), [&](int begin, int end)
+	{
+		A xs[detail::convert_chunk], ys[detail::convert_chunk], zs[detail::convert_chunk], ws[detail::convert_chunk];
+		for (int r = begin; r < end; ++r)
+		{
+			const T* ar = a.row_data(r);
+			const T* br = b.row_data(r);
+			const T* cr = c.row_data(r);
+			T* rr = detail::view_row(result, r);
+			for (int i = 0; i < cols; i += chunk)
+			{
+				int len = std::min(chunk, cols - i);
+				const A* x = detail::converted(ar + i, len, xs);
+				const A* y = detail::converted(br + i, len, ys);
+				const A* z = detail::converted(cr + i, len, zs);
+				A* w = detail::conversion_target(rr + i, ws);
+				for (int k = 0; k < len; ++k)
+					w[k] = x[k] * y[k] + z[k];
+				detail::store_converted(w, rr + i, len);
+			}
+		}
+	});
+}
+
+/**
+ * \brief Multiplies matrices element by element and adds third one
+ *
+ * \param a Matrix A
+ * \param b Matrix B
+ * \param c Matrix C
+ * \return New matrix containing a .* b + c
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> fma(const matrix<T>& a, const matrix<T>& b, const matrix<T>& c)
+{
+	matrix<T> result(a.rows(), a.cols());
+	fma(a, b, c, result);
+	return result;
+}
+
+}
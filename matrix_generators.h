@@ -39,11 +39,10 @@ static std::default_random_engine generator(static_cast<unsigned int>(seed));
  * \return Zero matrix
 */
 template<typename T>
-inline typename matrix<T> matrix<T>::zeros(int rows, int cols)
+inline matrix<T> matrix<T>::zeros(int rows, int cols)
 {
 	matrix<T> m(rows, cols);
-	for (auto i = m.begin(); i != m.end(); ++i)
-		*i = 0;
+	m.transform([](const T&) { return T(0); });
 	return m;
 }
 
@@ -57,7 +56,7 @@ inline typename matrix<T> matrix<T>::zeros(int rows, int cols)
  * \return Zero matrix
 */
 template<typename T>
-inline typename matrix<T> matrix<T>::zeros(int rows_cols)
+inline matrix<T> matrix<T>::zeros(int rows_cols)
 {
 	return zeros(rows_cols, rows_cols);
 }
@@ -73,11 +72,10 @@ inline typename matrix<T> matrix<T>::zeros(int rows_cols)
  * \return Matrix with ones
 */
 template<typename T>
-inline typename matrix<T> matrix<T>::ones(int rows, int cols)
+inline matrix<T> matrix<T>::ones(int rows, int cols)
 {
 	matrix<T> m(rows, cols);
-	for (auto i = m.begin(); i != m.end(); ++i)
-		*i = 1;
+	m.transform([](const T&) { return T(1); });
 	return m;
 }
 
@@ -91,7 +89,7 @@ inline typename matrix<T> matrix<T>::ones(int rows, int cols)
  * \return Matrix with ones
 */
 template<typename T>
-inline typename matrix<T> matrix<T>::ones(int rows_cols)
+inline matrix<T> matrix<T>::ones(int rows_cols)
 {
 	return ones(rows_cols, rows_cols);
 }
@@ -106,7 +104,7 @@ inline typename matrix<T> matrix<T>::ones(int rows_cols)
  * \return Identity matrix
 */
 template<typename T>
-inline typename matrix<T> matrix<T>::identity(int rows_cols)
+inline matrix<T> matrix<T>::identity(int rows_cols)
 {
 	matrix<T> m = zeros(rows_cols);
 	for (int i = 0; i < m.rows(); ++i)
@@ -129,7 +127,7 @@ inline typename matrix<T> matrix<T>::identity(int rows_cols)
 */
 template<typename T>
 template<typename R>
-inline typename matrix<T> matrix<T>::rand(int rows, int cols, R& random_distribution)
+inline matrix<T> matrix<T>::rand(int rows, int cols, R& random_distribution)
 {
 	matrix<T> m(rows, cols);
 	for (auto i = m.begin(); i != m.end(); ++i)
@@ -151,7 +149,7 @@ inline typename matrix<T> matrix<T>::rand(int rows, int cols, R& random_distribu
 */
 template<typename T>
 template<typename R>
-inline typename matrix<T> matrix<T>::rand(int rows_cols, R& random_distribution)
+inline matrix<T> matrix<T>::rand(int rows_cols, R& random_distribution)
 {
 	return rand(rows_cols, rows_cols, random_distribution);
 }
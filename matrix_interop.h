@@ -0,0 +1,145 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+
+#if defined(__has_include)
+#if __has_include(<mdspan>) && __cplusplus > 202002L
+#include <mdspan>
+#endif
+#endif
+
+#include "matrix_exception.h"
+
+namespace mn {
+
+/**
+ * \brief Wraps existing memory without taking ownership
+ *
+ * Creates matrix using rows * cols elements stored row-by-row at data.
+ * No elements are copied and memory is never released by matrix, so it has
+ * to outlive matrix and all its copies and submatrices.
+ *
+ * \param data Pointer to first element
+ * \param rows Number of matrix rows
+ * \param cols Number of matrix columns
+ * \return mn::matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> matrix<T>::wrap(T* data, int rows, int cols)
+{
+	return wrap(data, rows, cols, cols);
+}
+
+/**
+ * \brief Wraps existing memory with rows placed at fixed distance without taking ownership
+ *
+ * Row r starts at data + r * stride and contains cols elements. Memory
+ * between rows is never accessed. Matrix with stride other than cols
+ * behaves like submatrix (is not continuous). No elements are copied and
+ * memory is never released by matrix.
+ *
+ * \param data Pointer to first element
+ * \param rows Number of matrix rows
+ * \param cols Number of matrix columns
+ * \param stride Distance between beginnings of consecutive rows (in elements)
+ * \return mn::matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> matrix<T>::wrap(T* data, int rows, int cols, int stride)
+{
+	if (rows < 0 || cols < 0)
+		throw matrix_exception("invalid dimensions");
+	if (stride < cols)
+		throw matrix_exception("invalid stride");
+	if (data == nullptr && rows > 0 && cols > 0)
+		throw matrix_exception("null memory block");
+	matrix<T> m(std::shared_ptr<T>(std::shared_ptr<T>(), data), rows, stride);
+	m.p.c_end = cols - 1;
+	m.p.continuous = stride == cols;
+	return m;
+}
+
+#if defined(__cpp_lib_mdspan)
+
+/**
+ * \brief Returns std::mdspan viewing elements of matrix
+ *
+ * Works for submatrices too, as row stride is part of layout. Copy-on-write
+ * matrix is detached first. Matrix has to outlive the span.
+ *
+ * \param m Matrix
+ * \return std::mdspan with layout_stride
+*/
+template<typename T>
+inline std::mdspan<T, std::dextents<std::size_t, 2>, std::layout_stride> to_mdspan(matrix<T>& m)
+{
+	typedef std::dextents<std::size_t, 2> E;
+	std::array<std::size_t, 2> strides = { static_cast<std::size_t>(m.stride()), 1 };
+	return std::mdspan<T, E, std::layout_stride>(m.row_data(0), std::layout_stride::mapping<E>(E(m.rows(), m.cols()), strides));
+}
+
+/**
+ * \brief Returns read-only std::mdspan viewing elements of constant matrix
+ *
+ * Copy-on-write matrix is not detached. Matrix has to outlive the span.
+ *
+ * \param m Matrix
+ * \return std::mdspan of constant elements with layout_stride
+*/
+template<typename T>
+inline std::mdspan<const T, std::dextents<std::size_t, 2>, std::layout_stride> to_mdspan(const matrix<T>& m)
+{
+	typedef std::dextents<std::size_t, 2> E;
+	std::array<std::size_t, 2> strides = { static_cast<std::size_t>(m.stride()), 1 };
+	return std::mdspan<const T, E, std::layout_stride>(m.row_data(0), std::layout_stride::mapping<E>(E(m.rows(), m.cols()), strides));
+}
+
+/**
+ * \brief Wraps elements viewed by two-dimensional std::mdspan without copying
+ *
+ * Elements of every row have to be contiguous (stride of second extent
+ * equal to 1), e.g. spans with layout_right or row-major layout_stride.
+ * Memory is not owned by returned matrix.
+ *
+ * \param span Two-dimensional span
+ * \return mn::matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename E, typename L, typename A>
+inline matrix<T> from_mdspan(const std::mdspan<T, E, L, A>& span)
+{
+	static_assert(E::rank() == 2, "only two-dimensional spans may be wrapped");
+	int rows = static_cast<int>(span.extent(0)), cols = static_cast<int>(span.extent(1));
+	if (cols > 1 && span.stride(1) != 1)
+		throw matrix_exception("unsupported layout");
+	int stride = rows > 1 ? static_cast<int>(span.stride(0)) : cols;
+	return matrix<T>::wrap(span.data_handle(), rows, cols, stride);
+}
+
+#endif
+
+}
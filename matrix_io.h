@@ -26,19 +26,20 @@ namespace mn {
  * \brief Input stream operator for matrix
  *
  * This operator reads matrix from input stream (e.g. std::cin),
- * row-by-row. Assumes, that input stream provides correct values
- * of proper type.
+ * row-by-row, regardless of layout of matrix. Assumes, that input
+ * stream provides correct values of proper type.
  *
  * \param i Input stream
  * \param m Reference to matrix to read values to
  * \return Input stream
 */
-template<typename T>
-inline std::istream& operator>>(std::istream& i, matrix<T>& m)
+template<typename T, layout L>
+inline std::istream& operator>>(std::istream& i, matrix<T, L>& m)
 {
-	for (auto iterator = m.begin(); iterator != m.end(); ++iterator)
+	for (auto row = m.first_row(); row != m.last_row(); ++row)
 	{
-		i >> *iterator;
+		for (auto element = row.first_element(); element != row.last_element(); ++element)
+			i >> *element;
 	}
 
 	return i;
@@ -49,14 +50,15 @@ inline std::istream& operator>>(std::istream& i, matrix<T>& m)
  *
  * This operator prints matrix contents to output stream, such as
  * std::cout or file stream. It divides values to rows and adds
- * square brackets at the beginning and ending of output.
+ * square brackets at the beginning and ending of output. Matrices of
+ * both layouts are printed row-by-row.
  *
  * \param o Output stream
  * \param m Reference to matrix to print
  * \return Output stream
 */
-template<typename T>
-inline std::ostream& operator<<(std::ostream& o, const matrix<T>& m)
+template<typename T, layout L>
+inline std::ostream& operator<<(std::ostream& o, const matrix<T, L>& m)
 {
 	o << "[" << std::endl;
 	for (auto row = m.first_row(); row != m.last_row(); ++row)
@@ -72,7 +72,7 @@ inline typename matrix<T>::row_iterator matrix<T>::row_iterator::operator--(int)
 template<typename T>
 inline T& matrix<T>::row_iterator::operator[](const int index)
 {
-	return mem_block.get()[p.cols * r_index + p.c_begin + index];
+	return mem_block.get()[static_cast<std::ptrdiff_t>(p.cols) * r_index + p.c_begin + index];
 }
 
 /**
@@ -143,7 +143,7 @@ inline typename matrix<T>::const_row_iterator matrix<T>::const_row_iterator::ope
 template<typename T>
 inline const T& matrix<T>::const_row_iterator::operator[](const int index)
 {
-	return mem_block.get()[p.cols * r_index + p.c_begin + index];
+	return mem_block.get()[static_cast<std::ptrdiff_t>(p.cols) * r_index + p.c_begin + index];
 }
 
 /**
@@ -208,6 +208,15 @@ inline typename matrix<T>::col_iterator matrix<T>::col_iterator::operator--(int)
 	return old;
 }
 
+/**
+ * \brief Returns reference to column element at specified index
+*/
+template<typename T>
+inline T& matrix<T>::col_iterator::operator[](const int index)
+{
+	return mem_block.get()[static_cast<std::ptrdiff_t>(p.cols) * (p.r_begin + index) + c_index];
+}
+
 /**
  * \brief Returns column element iterator initialized with first element
 */
@@ -270,6 +279,15 @@ inline typename matrix<T>::const_col_iterator matrix<T>::const_col_iterator::ope
 	return old;
 }
 
+/**
+ * \brief Returns reference to column element of constant matrix at specified index
+*/
+template<typename T>
+inline const T& matrix<T>::const_col_iterator::operator[](const int index)
+{
+	return mem_block.get()[static_cast<std::ptrdiff_t>(p.cols) * (p.r_begin + index) + c_index];
+}
+
 /**
  * \brief Returns column element iterator of constant matrix initialized with first element
 */
@@ -354,7 +372,7 @@ inline typename matrix<T>::element_iterator matrix<T>::element_iterator::operato
 template<typename T>
 inline T& matrix<T>::element_iterator::operator*() const
 {
-	return mem_block.get()[p.cols * r_index + c_index];
+	return mem_block.get()[static_cast<std::ptrdiff_t>(p.cols) * r_index + c_index];
 }
 
 /**
@@ -363,7 +381,7 @@ inline T& matrix<T>::element_iterator::operator*() const
 template<typename T>
 inline T* matrix<T>::element_iterator::operator->() const
 {
-	return &(mem_block.get()[p.cols * r_index + c_index]);
+	return &(mem_block.get()[static_cast<std::ptrdiff_t>(p.cols) * r_index + c_index]);
 }
 
 /**
@@ -432,7 +450,7 @@ inline typename matrix<T>::const_element_iterator matrix<T>::const_element_itera
 template<typename T>
 inline const T& matrix<T>::const_element_iterator::operator*() const
 {
-	return mem_block.get()[p.cols * r_index + c_index];
+	return mem_block.get()[static_cast<std::ptrdiff_t>(p.cols) * r_index + c_index];
 }
 
 /**
@@ -441,7 +459,7 @@ inline const T& matrix<T>::const_element_iterator::operator*() const
 template<typename T>
 inline const T* matrix<T>::const_element_iterator::operator->() const
 {
-	return &(mem_block.get()[p.cols * r_index + c_index]);
+	return &(mem_block.get()[static_cast<std::ptrdiff_t>(p.cols) * r_index + c_index]);
 }
 
 /**
@@ -524,7 +542,7 @@ inline typename matrix<T>::iterator matrix<T>::iterator::operator--(int)
 template<typename T>
 inline T& matrix<T>::iterator::operator*() const
 {
-	return mem_block.get()[current_row * p.cols + current_col];
+	return mem_block.get()[static_cast<std::ptrdiff_t>(current_row) * p.cols + current_col];
 }
 
 /**
@@ -533,7 +551,7 @@ inline T& matrix<T>::iterator::operator*() const
 template<typename T>
 inline T* matrix<T>::iterator::operator->() const
 {
-	return &(mem_block.get()[current_row * p.cols + current_col]);
+	return &(mem_block.get()[static_cast<std::ptrdiff_t>(current_row) * p.cols + current_col]);
 }
 
 /**
@@ -616,7 +634,7 @@ inline typename matrix<T>::const_iterator matrix<T>::const_iterator::operator--(
 template<typename T>
 inline const T& matrix<T>::const_iterator::operator*() const
 {
-	return mem_block.get()[current_row * p.cols + current_col];
+	return mem_block.get()[static_cast<std::ptrdiff_t>(current_row) * p.cols + current_col];
 }
 
 /**
@@ -625,7 +643,7 @@ inline const T& matrix<T>::const_iterator::operator*() const
 template<typename T>
 inline const T* matrix<T>::const_iterator::operator->() const
 {
-	return &(mem_block.get()[current_row * p.cols + current_col]);
+	return &(mem_block.get()[static_cast<std::ptrdiff_t>(current_row) * p.cols + current_col]);
 }
 
 }
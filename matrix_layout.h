@@ -0,0 +1,345 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+#include "matrix_exception.h"
+#include "matrix_parallel.h"
+
+namespace mn {
+
+/**
+ * \brief mn::matrix<T, layout::col_major>
+ *
+ * Matrix of size rows x cols storing elements of every column one after
+ * another, for workloads accessing matrices column by column (e.g.
+ * statistics of features stored in columns). Memory block is held by
+ * row-major matrix of size cols x rows, whose rows are columns of this one
+ * (see storage()), so its iterators are used with roles of rows and
+ * columns swapped: m[r][c] reads column c at index r and element iterators
+ * walk columns first. Other operations of row-major matrices are available
+ * on storage(). Kernels (mn::gemm, mn::gemv, mn::syrk, mn::ger) and stream
+ * operators accept matrices of both layouts.
+*/
+template<typename T>
+class matrix<T, layout::col_major>
+{
+public:
+	typedef typename matrix<T>::col_iterator row_iterator; //!< Iterator over rows (columns of storage)
+	typedef typename matrix<T>::const_col_iterator const_row_iterator; //!< Iterator over rows of constant matrix
+	typedef typename matrix<T>::row_iterator col_iterator; //!< Iterator over columns (rows of storage)
+	typedef typename matrix<T>::const_row_iterator const_col_iterator; //!< Iterator over columns of constant matrix
+	typedef typename matrix<T>::iterator iterator; //!< Iterator over elements, column by column
+	typedef typename matrix<T>::const_iterator const_iterator; //!< Iterator over elements of constant matrix, column by column
+	typedef T value_type; //!< Type of matrix elements
+
+	matrix() {} //!< Default constructor
+
+	/**
+	 * \brief Constructor with dimensions
+	 *
+	 * \param rows Number of matrix rows
+	 * \param cols Number of matrix columns
+	 * \throws mn::matrix_exception
+	*/
+	matrix(int rows, int cols) : columns(cols, rows) {}
+
+	/**
+	 * \brief Creates matrix using rows of row-major matrix as its columns
+	 *
+	 * Elements are not copied, so result is transposition of m sharing its memory.
+	 *
+	 * \param m Row-major matrix of size cols x rows
+	 * \return Column-major matrix of size rows x cols
+	*/
+	static matrix<T, layout::col_major> from_storage(const matrix<T>& m) { matrix<T, layout::col_major> result; result.columns = m; return result; }
+
+	int rows() const { return columns.cols(); } //!< Returns number of rows
+	int cols() const { return columns.rows(); } //!< Returns number of columns
+	std::ptrdiff_t size() const { return columns.size(); } //!< Returns number of elements
+	bool is_continuous() const { return columns.is_continuous(); } //!< Returns true if columns are stored without gaps
+	bool is_square() const { return columns.is_square(); } //!< Returns true if matrix is square
+	int stride() const { return columns.stride(); } //!< Returns distance between beginnings of consecutive columns
+	T* col_data(const int index) { return columns.row_data(index); } //!< Returns pointer to first element of column
+	const T* col_data(const int index) const { return columns.row_data(index); } //!< Returns pointer to first element of column
+
+	row_iterator operator[](const int index) { return columns.col(index); } //!< Returns iterator of row, indexed by column
+	const_row_iterator operator[](const int index) const { return columns.col(index); } //!< Returns iterator of row, indexed by column
+	row_iterator first_row() { return columns.first_col(); } //!< Returns iterator of first row
+	const_row_iterator first_row() const { return columns.first_col(); } //!< Returns iterator of first row
+	row_iterator last_row() { return columns.last_col(); } //!< Returns iterator after last row
+	const_row_iterator last_row() const { return columns.last_col(); } //!< Returns iterator after last row
+	col_iterator first_col() { return columns.first_row(); } //!< Returns iterator of first column
+	const_col_iterator first_col() const { return columns.first_row(); } //!< Returns iterator of first column
+	col_iterator last_col() { return columns.last_row(); } //!< Returns iterator after last column
+	const_col_iterator last_col() const { return columns.last_row(); } //!< Returns iterator after last column
+	row_iterator row(const int index) { return columns.col(index); } //!< Returns iterator of row
+	const_row_iterator row(const int index) const { return columns.col(index); } //!< Returns iterator of row
+	col_iterator col(const int index) { return columns.row(index); } //!< Returns iterator of column
+	const_col_iterator col(const int index) const { return columns.row(index); } //!< Returns iterator of column
+	iterator begin() { return columns.begin(); } //!< Returns iterator of first element of first column
+	const_iterator begin() const { return columns.begin(); } //!< Returns iterator of first element of first column
+	iterator end() { return columns.end(); } //!< Returns iterator after last element of last column
+	const_iterator end() const { return columns.end(); } //!< Returns iterator after last element of last column
+
+	bool operator==(const matrix<T, layout::col_major>& m) const { return columns == m.columns; } //!< Compares elements of matrices
+	bool operator!=(const matrix<T, layout::col_major>& m) const { return columns != m.columns; } //!< Compares elements of matrices
+
+	/**
+	 * \brief Returns submatrix sharing memory with matrix
+	 *
+	 * Copy-on-write matrix is detached first.
+	 *
+	 * \param rows_from First row (inclusive)
+	 * \param rows_to Last row (inclusive)
+	 * \param cols_from First column (inclusive)
+	 * \param cols_to Last column (inclusive)
+	 * \return Column-major submatrix
+	 * \throws mn::matrix_exception
+	*/
+	matrix<T, layout::col_major> submatrix(int rows_from, int rows_to, int cols_from, int cols_to)
+	{
+		return from_storage(columns.submatrix(cols_from, cols_to, rows_from, rows_to));
+	}
+
+	/**
+	 * \brief Returns submatrix of constant matrix sharing memory with it
+	 *
+	 * Copy-on-write matrix is not detached, like in row-major matrices.
+	*/
+	matrix<T, layout::col_major> submatrix(int rows_from, int rows_to, int cols_from, int cols_to) const
+	{
+		return from_storage(columns.submatrix(cols_from, cols_to, rows_from, rows_to));
+	}
+
+	matrix<T> transpose() const { return columns.copy(); } //!< Returns transposed matrix (row-major copy of storage)
+	matrix<T, layout::col_major> copy() const { return from_storage(columns.copy()); } //!< Returns deep copy of matrix
+
+	matrix<T>& storage() { return columns; } //!< Returns row-major matrix whose rows are columns of this one
+	const matrix<T>& storage() const { return columns; } //!< Returns row-major matrix whose rows are columns of this one
+
+	void set_copy_on_write(bool enabled) { columns.set_copy_on_write(enabled); } //!< Enables or disables copy-on-write mode
+	bool is_copy_on_write() const { return columns.is_copy_on_write(); } //!< Returns true if copy-on-write is enabled
+	void detach() { columns.detach(); } //!< Makes copy-on-write matrix the only owner of its elements
+protected:
+	matrix<T> columns; //!< Row-major matrix whose rows are columns of this one
+};
+
+namespace detail {
+
+/**
+ * \brief Size of square tiles transposed at once
+ *
+ * Tile of source and tile of destination fit in L1 cache together.
+*/
+const int transpose_tile = 32;
+
+/**
+ * \brief Transposes rows x cols elements of source into destination
+ *
+ * Elements are copied in square tiles, so both source rows and destination
+ * rows are accessed in cache-sized blocks. Rows of tiles are processed in
+ * parallel.
+ *
+ * \param src First element of source
+ * \param src_stride Distance between source rows
+ * \param dst First element of destination
+ * \param dst_stride Distance between destination rows
+*/
+template<typename T>
+inline void transpose_elements(const T* src, std::ptrdiff_t src_stride, T* dst, std::ptrdiff_t dst_stride, int rows, int cols)
+{
+	int tiles = (rows + transpose_tile - 1) / transpose_tile;
+	parallel_for(0, tiles, parallel_grain(static_cast<long long>(transpose_tile) * cols), [&](int begin, int end)
+	{
+		for (int t = begin; t < end; ++t)
+		{
+			int r0 = t * transpose_tile;
+			int h = std::min(transpose_tile, rows - r0);
+			for (int c0 = 0; c0 < cols; c0 += transpose_tile)
+			{
+				int w = std::min(transpose_tile, cols - c0);
+				const T* s = src + r0 * src_stride + c0;
+				T* d = dst + c0 * dst_stride + r0;
+				for (int c = 0; c < w; ++c)
+				{
+					for (int r = 0; r < h; ++r)
+						d[c * dst_stride + r] = s[r * src_stride + c];
+				}
+			}
+		}
+	});
+}
+
+}
+
+/**
+ * \brief Copies transposition of matrix into another one
+ *
+ * Destination has to be of size cols() x rows() of source and may be
+ * submatrix (view). Elements are copied in cache-sized tiles in parallel,
+ * which is much faster than copying along columns for large matrices.
+ * If both matrices point to overlapping memory, source is copied to
+ * temporary matrix first. Copy-on-write destination is detached first.
+ *
+ * \param src Source matrix
+ * \param dst Destination matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void copy_transposed(const matrix<T>& src, matrix<T>& dst)
+{
+	dst.detach();
+	int rows = src.rows(), cols = src.cols();
+	if (dst.rows() != cols || dst.cols() != rows)
+		throw matrix_exception("dimensions mismatch");
+	if (rows == 0 || cols == 0)
+		return;
+	const T* src_first = src.row_data(0);
+	const T* src_last = src.row_data(rows - 1) + cols;
+	const T* dst_first = detail::view_row(dst, 0);
+	const T* dst_last = detail::view_row(dst, cols - 1) + rows;
+	if (std::less<const T*>()(src_first, dst_last) && std::less<const T*>()(dst_first, src_last))
+	{
+		matrix<T> tmp(rows, cols);
+		copy_block(src, tmp);
+		copy_transposed(tmp, dst);
+		return;
+	}
+	detail::transpose_elements(src_first, src.stride(), detail::view_row(dst, 0), dst.stride(), rows, cols);
+}
+
+/**
+ * \brief Copies transposition of matrix into temporary view
+ *
+ * Allows to pass submatrix directly, e.g. copy_transposed(m, t.submatrix(0, 9, 0, 19)).
+ *
+ * \param src Source matrix
+ * \param dst Destination view
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void copy_transposed(const matrix<T>& src, matrix<T>&& dst)
+{
+	copy_transposed(src, dst);
+}
+
+/**
+ * \brief Returns transposed matrix
+ *
+ * This method allocates new memory block and copies original matrix to it
+ * with rows and columns swapped (see mn::copy_transposed). Result is
+ * storage of column-major copy of original matrix (see mn::to_col_major).
+ *
+ * \return mn::matrix
+*/
+template<typename T>
+inline matrix<T> matrix<T>::transpose() const
+{
+	matrix<T> transposed = matrix<T>(cols(), rows());
+	copy_transposed(*this, transposed);
+	return transposed;
+}
+
+/**
+ * \brief Converts row-major matrix to column-major one
+ *
+ * Elements are copied with mn::copy_transposed (in tiles, in parallel).
+ *
+ * \param m Row-major matrix
+ * \return Column-major matrix of the same size
+*/
+template<typename T>
+inline matrix<T, layout::col_major> to_col_major(const matrix<T>& m)
+{
+	matrix<T, layout::col_major> result(m.rows(), m.cols());
+	copy_transposed(m, result.storage());
+	return result;
+}
+
+/**
+ * \brief Converts column-major matrix to row-major one
+ *
+ * Elements are copied with mn::copy_transposed (in tiles, in parallel).
+ *
+ * \param m Column-major matrix
+ * \return Row-major matrix of the same size
+*/
+template<typename T>
+inline matrix<T> to_row_major(const matrix<T, layout::col_major>& m)
+{
+	matrix<T> result(m.rows(), m.cols());
+	copy_transposed(m.storage(), result);
+	return result;
+}
+
+/**
+ * \brief Copies elements of matrix into memory block in specified order
+ *
+ * Writes rows() * cols() elements, e.g. to pass matrix to library
+ * expecting column-major arrays. Works for submatrices too.
+ *
+ * \param m Matrix
+ * \param data Destination memory block
+ * \param order Order of elements in destination
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void to_layout(const matrix<T>& m, T* data, layout order)
+{
+	if (order == layout::row_major)
+		copy_block(m, matrix<T>::wrap(data, m.rows(), m.cols()));
+	else
+		copy_transposed(m, matrix<T>::wrap(data, m.cols(), m.rows()));
+}
+
+/**
+ * \brief Creates matrix from elements stored in specified order
+ *
+ * Allocates new row-major matrix and copies rows * cols elements to it,
+ * converting column-major elements with mn::copy_transposed. Column-major
+ * block may also be wrapped without copying as transposed matrix, i.e.
+ * mn::matrix::wrap(data, cols, rows).
+ *
+ * \param data Source memory block
+ * \param rows Number of matrix rows
+ * \param cols Number of matrix columns
+ * \param order Order of elements in source
+ * \return mn::matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> from_layout(const T* data, int rows, int cols, layout order)
+{
+	matrix<T> m(rows, cols);
+	// Source is only read, wrapping needs non-const pointer
+	T* src = const_cast<T*>(data);
+	if (order == layout::row_major)
+		copy_block(matrix<T>::wrap(src, rows, cols), m);
+	else
+		copy_transposed(matrix<T>::wrap(src, cols, rows), m);
+	return m;
+}
+
+}
@@ -0,0 +1,202 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "matrix_exception.h"
+#include "matrix_shared.h"
+
+namespace mn {
+
+/**
+ * \brief Expected access pattern of matrix elements (see mn::advise)
+*/
+enum class access_pattern
+{
+	normal, //!< No special treatment
+	sequential, //!< Elements will be read in order, pages may be read ahead aggressively
+	random, //!< Elements will be read in random order, read-ahead is disabled
+	willneed, //!< Elements will be needed soon, pages are read in background
+	dontneed //!< Elements will not be needed soon, pages may be dropped from memory (mapped files and shared memory only)
+};
+
+namespace detail {
+
+/**
+ * \brief Returns page-aligned range of mapping containing all rows of matrix
+ *
+ * \param begin Set to first byte of range
+ * \return Length of range in bytes (0 for empty matrix)
+*/
+template<typename T>
+inline std::size_t page_range(const matrix<T>& m, char*& begin)
+{
+	if (m.rows() == 0 || m.cols() == 0)
+		return 0;
+	std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+	std::uintptr_t first = reinterpret_cast<std::uintptr_t>(m.row_data(0));
+	std::uintptr_t last = reinterpret_cast<std::uintptr_t>(m.row_data(m.rows() - 1) + m.cols());
+	first -= first % page;
+	begin = reinterpret_cast<char*>(first);
+	return static_cast<std::size_t>(last - first);
+}
+
+}
+
+/**
+ * \brief Creates matrix stored in file mapped into memory
+ *
+ * File has the same layout as shared matrix: small header describing
+ * dimensions and element type, followed by elements, which are initialized
+ * to zeros. Existing file is truncated. Elements written to matrix are
+ * written back to file by operating system at any time, or explicitly with
+ * mn::sync_matrix. File is marked as complete only by
+ * mn::finalize_mapped_matrix, so file left by process killed while writing
+ * it is rejected by mn::open_mapped_matrix. Only trivially copyable element
+ * types may be stored.
+ *
+ * \param path Path of file
+ * \param rows Number of matrix rows
+ * \param cols Number of matrix columns
+ * \return Writable matrix using mapped file
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> create_mapped_matrix(const std::string& path, int rows, int cols)
+{
+	int fd = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR, 0644);
+	if (fd < 0)
+		throw matrix_exception("cannot create file");
+	try
+	{
+		return detail::create_mapping<T>(fd, rows, cols);
+	}
+	catch (...)
+	{
+		unlink(path.c_str());
+		throw;
+	}
+}
+
+/**
+ * \brief Writes elements and then header of mapped matrix file to storage
+ *
+ * Marks file as complete. Elements are flushed to storage before header is
+ * updated, so after crash file is either complete or rejected by
+ * mn::open_mapped_matrix. Should be called after all elements are written.
+ *
+ * \param path Path of file
+ * \throws mn::matrix_exception
+*/
+inline void finalize_mapped_matrix(const std::string& path)
+{
+	int fd = open(path.c_str(), O_RDWR);
+	if (fd < 0)
+		throw matrix_exception("cannot open file");
+	detail::mark_ready(fd, true);
+}
+
+/**
+ * \brief Opens complete matrix file and maps it into memory
+ *
+ * Maps file in O(1) time after validating its header. Elements are read
+ * from file lazily, when their pages are accessed for the first time.
+ * Writes to writable matrix modify file. Read-only matrix must not be
+ * modified (writes cause segmentation fault).
+ *
+ * \param path Path of file
+ * \param writable Maps elements read-write
+ * \return Matrix using mapped file
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> open_mapped_matrix(const std::string& path, bool writable = false)
+{
+	int fd = open(path.c_str(), writable ? O_RDWR : O_RDONLY);
+	if (fd < 0)
+		throw matrix_exception("cannot open file");
+	return detail::open_mapping<T>(fd, !writable, "incomplete matrix file");
+}
+
+/**
+ * \brief Writes modified elements of mapped matrix back to file
+ *
+ * Only pages containing rows of matrix are written, so syncing submatrix
+ * flushes just its range of file instead of whole mapping. Pages which were
+ * not modified are skipped by operating system.
+ *
+ * \param m Matrix or submatrix of mapped matrix
+ * \param async Schedules writes and returns immediately instead of waiting for them
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void sync_matrix(const matrix<T>& m, bool async = false)
+{
+	char* begin = nullptr;
+	std::size_t length = detail::page_range(m, begin);
+	if (length != 0 && msync(begin, length, async ? MS_ASYNC : MS_SYNC) != 0)
+		throw matrix_exception("cannot sync matrix");
+}
+
+/**
+ * \brief Tells operating system how elements of mapped matrix will be accessed
+ *
+ * Hint applies to pages containing rows of matrix (or submatrix), e.g.
+ * access_pattern::sequential before streaming whole matrix from file,
+ * access_pattern::willneed to prefetch block which will be processed next
+ * or access_pattern::dontneed to drop block which was already processed.
+ * Hints are only advisory and failures are ignored. Should be used only
+ * for matrices using mapped files or shared memory. Dropped pages of other
+ * memory would be replaced with zeros, so access_pattern::dontneed is
+ * ignored unless all pages of matrix belong to mapped file or shared memory
+ * object (a mapped matrix detached by copy-on-write no longer does).
+ *
+ * \param m Matrix or submatrix of mapped matrix
+ * \param pattern Expected access pattern
+*/
+template<typename T>
+inline void advise(const matrix<T>& m, access_pattern pattern)
+{
+	char* begin = nullptr;
+	std::size_t length = detail::page_range(m, begin);
+	if (length == 0)
+		return;
+	if (pattern == access_pattern::dontneed && !detail::shared_mappings::instance().contain(begin, length))
+		return;
+	int advice = pattern == access_pattern::sequential ? MADV_SEQUENTIAL :
+		pattern == access_pattern::random ? MADV_RANDOM :
+		pattern == access_pattern::willneed ? MADV_WILLNEED :
+		pattern == access_pattern::dontneed ? MADV_DONTNEED : MADV_NORMAL;
+	madvise(begin, length, advice);
+}
+
+}
+
+#endif
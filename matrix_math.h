@@ -0,0 +1,370 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "matrix_precision.h"
+
+namespace mn {
+
+/**
+ * \brief Selects implementation of element-wise math functions
+*/
+enum class accuracy
+{
+	fast, //!< Vectorizable polynomial approximations (float), see mn::math
+	precise //!< Functions of standard library, called for every element
+};
+
+namespace detail {
+
+/**
+ * \brief Reinterprets bits of float as integer
+*/
+inline std::int32_t float_bits(float x)
+{
+	std::int32_t i;
+	std::memcpy(&i, &x, sizeof(i));
+	return i;
+}
+
+/**
+ * \brief Reinterprets integer as bits of float
+*/
+inline float bits_float(std::int32_t i)
+{
+	float x;
+	std::memcpy(&x, &i, sizeof(x));
+	return x;
+}
+
+}
+
+/**
+ * \brief Scalar math functions used by element-wise matrix functions
+ *
+ * Float versions are branch-free polynomial approximations, which may be
+ * vectorized by compiler when called in loops, e.g. in lambdas passed to
+ * mn::matrix::map or mn::matrix::transform. Maximal errors, measured
+ * against double precision results on every fourth float bit pattern, are:
+ * exp 1.02 ULP, log 0.83 ULP, tanh 1.34 ULP, sigmoid 2.48 ULP (near
+ * x = -16.6357, where errors of exp, addition and division add up).
+ * Special values (infinities, NaN, zero and negative arguments of log)
+ * are handled like in standard library, except that subnormal results of
+ * exp and sigmoid are flushed to zero. Versions for other types call
+ * standard library.
+*/
+namespace math {
+
+/**
+ * \brief Calculates exponential function (generic version)
+*/
+template<typename T>
+inline T exp(T x)
+{
+	return static_cast<T>(std::exp(x));
+}
+
+/**
+ * \brief Calculates exponential function of float (max. error 1.02 ULP)
+ *
+ * Argument is reduced to r = x - n * ln(2), |r| <= ln(2) / 2, e^r is
+ * approximated by polynomial and scaled by 2^n.
+*/
+inline float exp(float x)
+{
+	const float hi = 88.7228394f, lo = -87.3365479f;
+	float y = x < hi ? x : hi;
+	y = y > lo ? y : lo;
+	float t = y * 1.44269504f + 12582912.0f;
+	float n = t - 12582912.0f;
+	float r = y - n * 0.693359375f;
+	r = r + n * 2.12194440e-4f;
+	float p = 1.9875691500e-4f;
+	p = p * r + 1.3981999507e-3f;
+	p = p * r + 8.3334519073e-3f;
+	p = p * r + 4.1665795894e-2f;
+	p = p * r + 1.6666665459e-1f;
+	p = p * r + 5.0000001201e-1f;
+	p = p * r * r + r + 1.0f;
+	std::int32_t e = static_cast<std::int32_t>(n);
+	std::int32_t e1 = e >> 1;
+	float result = p * detail::bits_float((e1 + 127) << 23) * detail::bits_float((e - e1 + 127) << 23);
+	result = x > hi ? std::numeric_limits<float>::infinity() : result;
+	result = x < lo ? 0.0f : result;
+	return x == x ? result : x;
+}
+
+/**
+ * \brief Calculates natural logarithm (generic version)
+*/
+template<typename T>
+inline T log(T x)
+{
+	return static_cast<T>(std::log(x));
+}
+
+/**
+ * \brief Calculates natural logarithm of float (max. error 0.83 ULP)
+ *
+ * Argument is split into exponent e and mantissa m from [sqrt(2) / 2, sqrt(2)),
+ * log(m) is approximated by polynomial and e * ln(2) is added.
+*/
+inline float log(float x)
+{
+	const float min_normal = std::numeric_limits<float>::min();
+	bool subnormal = x < min_normal;
+	std::int32_t i = detail::float_bits(subnormal ? x * 8388608.0f : x);
+	std::int32_t e = ((i >> 23) & 0xff) - (subnormal ? 149 : 126);
+	float m = detail::bits_float((i & 0x007fffff) | 0x3f000000);
+	bool small = m < 0.707106781f;
+	float fe = static_cast<float>(e) - (small ? 1.0f : 0.0f);
+	m = (small ? m + m : m) - 1.0f;
+	float z = m * m;
+	float p = 7.0376836292e-2f;
+	p = p * m - 1.1514610310e-1f;
+	p = p * m + 1.1676998740e-1f;
+	p = p * m - 1.2420140846e-1f;
+	p = p * m + 1.4249322787e-1f;
+	p = p * m - 1.6668057665e-1f;
+	p = p * m + 2.0000714765e-1f;
+	p = p * m - 2.4999993993e-1f;
+	p = p * m + 3.3333331174e-1f;
+	float r = p * m * z;
+	r = r - 2.12194440e-4f * fe;
+	r = r - 0.5f * z;
+	r = m + r;
+	r = r + 0.693359375f * fe;
+	r = x == std::numeric_limits<float>::infinity() ? x : r;
+	r = x == 0.0f ? -std::numeric_limits<float>::infinity() : r;
+	r = x < 0.0f ? std::numeric_limits<float>::quiet_NaN() : r;
+	return x == x ? r : x;
+}
+
+/**
+ * \brief Calculates hyperbolic tangent (generic version)
+*/
+template<typename T>
+inline T tanh(T x)
+{
+	return static_cast<T>(std::tanh(x));
+}
+
+/**
+ * \brief Calculates hyperbolic tangent of float (max. error 1.34 ULP)
+ *
+ * Small arguments use odd polynomial, others 1 - 2 / (e^(2|x|) + 1).
+*/
+inline float tanh(float x)
+{
+	float a = x < 0.0f ? -x : x;
+	float z = x * x;
+	float p = -5.70498872745e-3f;
+	p = p * z + 2.06390887954e-2f;
+	p = p * z - 5.37397155531e-2f;
+	p = p * z + 1.33314422036e-1f;
+	p = p * z - 3.33332819422e-1f;
+	float small = p * z * x + x;
+	float large = 1.0f - 2.0f / (exp(a + a) + 1.0f);
+	large = x < 0.0f ? -large : large;
+	return a < 0.625f ? small : (x == x ? large : x);
+}
+
+/**
+ * \brief Calculates logistic sigmoid function 1 / (1 + e^-x) (generic version)
+*/
+template<typename T>
+inline T sigmoid(T x)
+{
+	return static_cast<T>(T(1) / (T(1) + std::exp(-x)));
+}
+
+/**
+ * \brief Calculates logistic sigmoid function 1 / (1 + e^-x) of float (max. error 2.48 ULP)
+*/
+inline float sigmoid(float x)
+{
+	return 1.0f / (1.0f + exp(-x));
+}
+
+/**
+ * \brief Calculates power function (generic version)
+*/
+template<typename T>
+inline T pow(T x, T p)
+{
+	return static_cast<T>(std::pow(x, p));
+}
+
+/**
+ * \brief Calculates power function of float
+ *
+ * Calculated as e^(p * log(|x|)). Negative bases are handled like in
+ * standard library: result has sign of x for odd integer exponents, is
+ * positive for even ones and NaN for exponents which are not integers.
+ * Unlike other approximations, its error has no fixed bound: relative
+ * error grows with |p * log(x)| and is about (|p * log(x)| + 2) ULP.
+*/
+inline float pow(float x, float p)
+{
+	float a = x < 0.0f ? -x : x;
+	float r = exp(p * log(a));
+	float half = 0.5f * p;
+	bool integer = std::floor(p) == p;
+	bool odd = integer && std::floor(half) != half;
+	float negative = integer ? (odd ? -r : r) : std::numeric_limits<float>::quiet_NaN();
+	r = x < 0.0f ? negative : r;
+	return p == 0.0f ? 1.0f : r;
+}
+
+}
+
+namespace detail {
+
+/**
+ * \brief Applies function calculated in accumulator type to every element of matrix
+ *
+ * Reduced precision elements are converted in chunks (see mn::detail::apply).
+*/
+template<typename T, typename F, typename P>
+inline matrix<T> apply_math(const matrix<T>& m, accuracy acc, F fast, P precise)
+{
+	matrix<T> result(m.rows(), m.cols());
+	if (acc == accuracy::fast)
+		apply(m, result, fast);
+	else
+		apply(m, result, precise);
+	return result;
+}
+
+}
+
+/**
+ * \brief Calculates exponential function of every element of matrix
+ *
+ * Allocates new matrix. Rows of large matrices are processed in parallel.
+ * Fast approximation is described in mn::math.
+ *
+ * \param m Matrix
+ * \param acc Selects fast approximation or standard library function
+ * \return New matrix containing results
+*/
+template<typename T>
+inline matrix<T> exp(const matrix<T>& m, accuracy acc = accuracy::fast)
+{
+	typedef accumulator_t<T> A;
+	return detail::apply_math(m, acc, [](A x) { return math::exp(x); }, [](A x) { return std::exp(x); });
+}
+
+/**
+ * \brief Calculates natural logarithm of every element of matrix
+ *
+ * Allocates new matrix. Rows of large matrices are processed in parallel.
+ * Fast approximation is described in mn::math.
+ *
+ * \param m Matrix
+ * \param acc Selects fast approximation or standard library function
+ * \return New matrix containing results
+*/
+template<typename T>
+inline matrix<T> log(const matrix<T>& m, accuracy acc = accuracy::fast)
+{
+	typedef accumulator_t<T> A;
+	return detail::apply_math(m, acc, [](A x) { return math::log(x); }, [](A x) { return std::log(x); });
+}
+
+/**
+ * \brief Calculates hyperbolic tangent of every element of matrix
+ *
+ * Allocates new matrix. Rows of large matrices are processed in parallel.
+ * Fast approximation is described in mn::math.
+ *
+ * \param m Matrix
+ * \param acc Selects fast approximation or standard library function
+ * \return New matrix containing results
+*/
+template<typename T>
+inline matrix<T> tanh(const matrix<T>& m, accuracy acc = accuracy::fast)
+{
+	typedef accumulator_t<T> A;
+	return detail::apply_math(m, acc, [](A x) { return math::tanh(x); }, [](A x) { return std::tanh(x); });
+}
+
+/**
+ * \brief Calculates logistic sigmoid function of every element of matrix
+ *
+ * Allocates new matrix. Rows of large matrices are processed in parallel.
+ * Fast approximation is described in mn::math.
+ *
+ * \param m Matrix
+ * \param acc Selects fast approximation or standard library function
+ * \return New matrix containing results
+*/
+template<typename T>
+inline matrix<T> sigmoid(const matrix<T>& m, accuracy acc = accuracy::fast)
+{
+	typedef accumulator_t<T> A;
+	return detail::apply_math(m, acc, [](A x) { return math::sigmoid(x); }, [](A x) { return A(1) / (A(1) + std::exp(-x)); });
+}
+
+/**
+ * \brief Calculates square root of every element of matrix
+ *
+ * Square root is always correctly rounded, as it is calculated by single
+ * instruction.
+ *
+ * \param m Matrix
+ * \return New matrix containing results
+*/
+template<typename T>
+inline matrix<T> sqrt(const matrix<T>& m)
+{
+	typedef accumulator_t<T> A;
+	matrix<T> result(m.rows(), m.cols());
+	detail::apply(m, result, [](A x) { return std::sqrt(x); });
+	return result;
+}
+
+/**
+ * \brief Raises every element of matrix to power
+ *
+ * Allocates new matrix. Rows of large matrices are processed in parallel.
+ * Fast approximation is described in mn::math; its error grows with
+ * |p * log(x)|, so precise version is recommended for large exponents.
+ *
+ * \param m Matrix
+ * \param p Exponent
+ * \param acc Selects fast approximation or standard library function
+ * \return New matrix containing results
+*/
+template<typename T>
+inline matrix<T> pow(const matrix<T>& m, const typename matrix<T>::value_type& p, accuracy acc = accuracy::fast)
+{
+	typedef accumulator_t<T> A;
+	A e = static_cast<A>(p);
+	return detail::apply_math(m, acc, [e](A x) { return math::pow(x, e); }, [e](A x) { return std::pow(x, e); });
+}
+
+}
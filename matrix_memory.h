@@ -0,0 +1,746 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "matrix_exception.h"
+#include "matrix_parallel.h"
+
+namespace mn {
+
+/**
+ * \brief Selects placement of memory blocks of large matrices on NUMA nodes
+ *
+ * Workers of mn::thread_pool are not pinned to nodes and claim tasks
+ * dynamically, so policies only decide where pages are placed, not which
+ * threads later process rows stored in them.
+*/
+enum class numa_policy
+{
+	first_touch, //!< Default of operating system, pages are placed on node of thread which writes them first
+	local, //!< Pages are first touched in parallel by thread pool, so they are spread over nodes the workers run on
+	interleaved, //!< Pages are interleaved round-robin between all nodes
+	partitioned //!< Consecutive blocks of rows are placed on consecutive nodes (preferred, not bound)
+};
+
+/**
+ * \brief Settings of NUMA-aware allocation
+ *
+ * Policy is applied only to memory blocks of trivially copyable and
+ * trivially destructible types containing at least min_bytes bytes and
+ * only on machines with more than one NUMA node (see mn::numa_nodes).
+ * Other blocks are allocated with new T[].
+*/
+struct numa_settings
+{
+	numa_policy policy; //!< Placement policy of new memory blocks
+	std::size_t min_bytes; //!< Minimal size of memory block placed according to policy
+};
+
+/**
+ * \brief Returns global NUMA settings
+ *
+ * Settings may be modified directly, e.g.
+ * mn::numa_config().policy = mn::numa_policy::interleaved.
+ *
+ * \return Reference to settings
+*/
+inline numa_settings& numa_config()
+{
+	static numa_settings settings = { numa_policy::first_touch, std::size_t(1) << 22 };
+	return settings;
+}
+
+/**
+ * \brief Selects use of huge pages for memory blocks of large matrices
+*/
+enum class huge_page_mode
+{
+	none, //!< Pages of default size
+	transparent, //!< Blocks aligned to huge page size and marked with madvise(MADV_HUGEPAGE)
+	hugetlb //!< Explicit huge pages (MAP_HUGETLB), falls back to transparent ones when none are available
+};
+
+/**
+ * \brief Settings of huge page allocation
+ *
+ * Huge pages are used only for memory blocks of trivially copyable and
+ * trivially destructible types containing at least min_bytes bytes on Linux. Such blocks are mapped with mmap and
+ * first touched in parallel by thread pool.
+*/
+struct huge_page_settings
+{
+	huge_page_mode mode; //!< Kind of huge pages used for new memory blocks
+	std::size_t min_bytes; //!< Minimal size of memory block allocated with huge pages
+};
+
+/**
+ * \brief Returns global huge page settings
+ *
+ * Settings may be modified directly, e.g.
+ * mn::huge_page_config().mode = mn::huge_page_mode::transparent.
+ *
+ * \return Reference to settings
+*/
+inline huge_page_settings& huge_page_config()
+{
+	static huge_page_settings settings = { huge_page_mode::none, std::size_t(1) << 22 };
+	return settings;
+}
+
+/**
+ * \brief Statistics of huge page allocation
+*/
+struct huge_page_stats
+{
+	std::size_t blocks; //!< Number of memory blocks allocated with huge pages requested
+	std::size_t requested_pages; //!< Number of huge pages covering these blocks
+	std::size_t fallbacks; //!< Number of explicit huge page requests which fell back to transparent ones
+	std::size_t live_pages; //!< Number of huge pages covering blocks which are still allocated
+	std::size_t obtained_pages; //!< Number of huge pages actually backing blocks which are still allocated
+};
+
+namespace detail {
+
+/**
+ * \brief Returns global counters of huge page statistics (blocks, requested pages, fallbacks)
+*/
+inline std::atomic<std::size_t>* huge_page_counters()
+{
+	static std::atomic<std::size_t> counters[3] = {};
+	return counters;
+}
+
+/**
+ * \brief mn::detail::huge_page_blocks
+ *
+ * Memory blocks allocated with huge pages requested which are still
+ * allocated. Pages backing them are counted only when statistics are
+ * queried, so allocation does not read /proc/self/smaps.
+*/
+struct huge_page_blocks
+{
+	std::mutex lock; //!< Guards blocks
+	std::map<std::uintptr_t, std::pair<std::size_t, bool>> blocks; //!< Length and kind of pages (true if explicit) by first byte
+
+	/**
+	 * \brief Returns global registry of blocks
+	 *
+	 * Registry is never destroyed, as matrices with static storage duration
+	 * may be destroyed after other static objects.
+	*/
+	static huge_page_blocks& instance()
+	{
+		static huge_page_blocks* registry = new huge_page_blocks();
+		return *registry;
+	}
+};
+
+/**
+ * \brief Returns identifiers of online NUMA nodes
+ *
+ * Nodes are read once from /sys/devices/system/node/online. Single node 0
+ * is returned if the list is not available.
+*/
+inline const std::vector<int>& numa_node_ids()
+{
+	static const std::vector<int> ids = []
+	{
+		std::vector<int> nodes;
+#if defined(__linux__)
+		if (std::FILE* f = std::fopen("/sys/devices/system/node/online", "r"))
+		{
+			int first, last;
+			while (std::fscanf(f, "%d", &first) == 1)
+			{
+				last = first;
+				int c = std::fgetc(f);
+				if (c == '-')
+				{
+					if (std::fscanf(f, "%d", &last) != 1)
+						break;
+					c = std::fgetc(f);
+				}
+				for (int node = first; node <= last; ++node)
+					nodes.push_back(node);
+				if (c != ',')
+					break;
+			}
+			std::fclose(f);
+		}
+#endif
+		if (nodes.empty())
+			nodes.push_back(0);
+		return nodes;
+	}();
+	return ids;
+}
+
+#if defined(__linux__)
+
+const int mpol_preferred = 1; //!< MPOL_PREFERRED mode of mbind
+const int mpol_interleave = 3; //!< MPOL_INTERLEAVE mode of mbind
+
+/**
+ * \brief Returns size of memory page
+*/
+inline std::size_t page_size()
+{
+	static const std::size_t size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	return size;
+}
+
+/**
+ * \brief Sets NUMA policy of page-aligned memory range (raw mbind system call)
+ *
+ * Failures are ignored, so pages are then placed by operating system.
+*/
+inline void bind_pages(void* addr, std::size_t bytes, int mode, const std::vector<int>& nodes)
+{
+	const int bits = std::numeric_limits<unsigned long>::digits;
+	int max_node = 0;
+	for (int node : nodes)
+		max_node = std::max(max_node, node);
+	std::vector<unsigned long> mask(max_node / bits + 1);
+	for (int node : nodes)
+		mask[node / bits] |= 1UL << (node % bits);
+	// Kernel ignores the last bit of maxnode, so mask of N bits is passed as N + 1
+	syscall(SYS_mbind, addr, bytes, mode, mask.data(), static_cast<unsigned long>(mask.size() * bits + 1), 0U);
+}
+
+/**
+ * \brief Writes every page of memory block in parallel
+ *
+ * Rows are split between threads like in mn::parallel_for and every thread
+ * touches pages starting within its rows. Pages without policy are placed
+ * on nodes of threads that faulted them in.
+*/
+inline void touch_pages(char* block, int rows, int cols, std::size_t row_bytes)
+{
+	const std::size_t page = page_size();
+	parallel_for(0, rows, parallel_grain(cols), [&](int begin, int end)
+	{
+		std::size_t first = (begin * row_bytes + page - 1) / page * page;
+		std::size_t last = end * row_bytes;
+		for (std::size_t offset = first; offset < last; offset += page)
+			block[offset] = 0;
+	});
+}
+
+/**
+ * \brief Returns size of huge page (read once from /proc/meminfo, 2 MB by default)
+*/
+inline std::size_t huge_page_size()
+{
+	static const std::size_t size = []
+	{
+		std::size_t kb = 2048;
+		if (std::FILE* f = std::fopen("/proc/meminfo", "r"))
+		{
+			char line[256];
+			while (std::fgets(line, sizeof(line), f))
+			{
+				if (std::sscanf(line, "Hugepagesize: %zu kB", &kb) == 1)
+					break;
+			}
+			std::fclose(f);
+		}
+		return kb * 1024;
+	}();
+	return size;
+}
+
+/**
+ * \brief Address range of mapping and size of transparent huge pages backing it
+*/
+struct anon_huge_mapping
+{
+	std::uintptr_t first; //!< First byte of mapping
+	std::uintptr_t last; //!< Next byte after mapping
+	std::size_t huge_bytes; //!< AnonHugePages of mapping (in bytes)
+};
+
+/**
+ * \brief Reads mappings of process and sizes of transparent huge pages backing them
+ *
+ * \return Every mapping in /proc/self/smaps, in order of addresses
+*/
+inline std::vector<anon_huge_mapping> anon_huge_mappings()
+{
+	std::vector<anon_huge_mapping> mappings;
+	if (std::FILE* f = std::fopen("/proc/self/smaps", "r"))
+	{
+		char line[512];
+		unsigned long long first, last;
+		std::size_t kb;
+		while (std::fgets(line, sizeof(line), f))
+		{
+			if (std::sscanf(line, "%llx-%llx ", &first, &last) == 2)
+			{
+				anon_huge_mapping m = { static_cast<std::uintptr_t>(first), static_cast<std::uintptr_t>(last), 0 };
+				mappings.push_back(m);
+			}
+			else if (!mappings.empty() && std::sscanf(line, "AnonHugePages: %zu kB", &kb) == 1)
+				mappings.back().huge_bytes = kb * 1024;
+		}
+		std::fclose(f);
+	}
+	return mappings;
+}
+
+/**
+ * \brief Returns number of transparent huge pages backing memory range [addr, addr + bytes)
+ *
+ * Sums AnonHugePages of all mappings overlapping the range, as range may
+ * be split by different NUMA policies of its parts. Mappings merged with
+ * neighbouring memory may count pages outside of the range, so result is
+ * limited to number of huge pages fitting in it.
+ *
+ * \param mappings Mappings read by mn::detail::anon_huge_mappings
+*/
+inline std::size_t transparent_huge_pages(const std::vector<anon_huge_mapping>& mappings, std::uintptr_t addr, std::size_t bytes)
+{
+	std::size_t total = 0;
+	auto it = std::upper_bound(mappings.begin(), mappings.end(), addr,
+		[](std::uintptr_t a, const anon_huge_mapping& m) { return a < m.last; });
+	for (; it != mappings.end() && it->first < addr + bytes; ++it)
+		total += it->huge_bytes;
+	return std::min(total, bytes) / huge_page_size();
+}
+
+/**
+ * \brief Maps anonymous memory aligned to multiple of alignment
+ *
+ * Length has to be a multiple of page size. Unused parts of larger mapping
+ * are unmapped.
+*/
+inline void* map_aligned(std::size_t bytes, std::size_t alignment)
+{
+	std::size_t len = bytes + alignment;
+	void* addr = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (addr == MAP_FAILED)
+		throw std::bad_alloc();
+	char* p = static_cast<char*>(addr);
+	char* aligned = p + (alignment - reinterpret_cast<std::uintptr_t>(p) % alignment) % alignment;
+	if (aligned > p)
+		munmap(p, aligned - p);
+	if (p + len > aligned + bytes)
+		munmap(aligned + bytes, p + len - (aligned + bytes));
+	return aligned;
+}
+
+/**
+ * \brief Allocates memory block with mmap, huge pages and pages placed according to NUMA policy
+ *
+ * Pages are first touched in parallel after policy is set.
+*/
+template<typename T>
+inline std::shared_ptr<T> allocate_pages(int rows, int cols, numa_policy policy, huge_page_mode huge)
+{
+	std::size_t row_bytes = static_cast<std::size_t>(cols) * sizeof(T);
+	std::size_t bytes = rows * row_bytes;
+	std::size_t page = huge == huge_page_mode::none ? page_size() : huge_page_size();
+	std::size_t mapped = (bytes + page - 1) / page * page;
+	std::atomic<std::size_t>* stats = huge_page_counters();
+	void* addr = MAP_FAILED;
+	bool explicit_pages = false;
+#if defined(MAP_HUGETLB)
+	if (huge == huge_page_mode::hugetlb)
+	{
+		addr = mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		explicit_pages = addr != MAP_FAILED;
+	}
+#endif
+	if (huge == huge_page_mode::hugetlb && !explicit_pages)
+		++stats[2];
+	if (addr == MAP_FAILED)
+	{
+		addr = map_aligned(mapped, page);
+#if defined(MADV_HUGEPAGE)
+		if (huge != huge_page_mode::none)
+			madvise(addr, mapped, MADV_HUGEPAGE);
+#endif
+	}
+
+	const std::vector<int>& nodes = numa_node_ids();
+	if (policy == numa_policy::interleaved)
+		bind_pages(addr, mapped, mpol_interleave, nodes);
+	else if (policy == numa_policy::partitioned)
+	{
+		int parts = static_cast<int>(nodes.size());
+		for (int i = 0; i < parts; ++i)
+		{
+			std::size_t first = static_cast<std::size_t>(static_cast<long long>(rows) * i / parts) * row_bytes / page * page;
+			std::size_t last = static_cast<std::size_t>(static_cast<long long>(rows) * (i + 1) / parts) * row_bytes / page * page;
+			if (i == parts - 1)
+				last = mapped;
+			if (last > first)
+				bind_pages(static_cast<char*>(addr) + first, last - first, mpol_preferred, std::vector<int>(1, nodes[i]));
+		}
+	}
+	touch_pages(static_cast<char*>(addr), rows, cols, row_bytes);
+
+	if (huge == huge_page_mode::none)
+		return std::shared_ptr<T>(static_cast<T*>(addr), [mapped](T* ptr) { munmap(ptr, mapped); });
+	++stats[0];
+	stats[1] += mapped / page;
+	huge_page_blocks& registry = huge_page_blocks::instance();
+	{
+		std::lock_guard<std::mutex> guard(registry.lock);
+		registry.blocks[reinterpret_cast<std::uintptr_t>(addr)] = std::make_pair(mapped, explicit_pages);
+	}
+	return std::shared_ptr<T>(static_cast<T*>(addr), [mapped](T* ptr)
+	{
+		huge_page_blocks& registry = huge_page_blocks::instance();
+		{
+			std::lock_guard<std::mutex> guard(registry.lock);
+			registry.blocks.erase(reinterpret_cast<std::uintptr_t>(ptr));
+		}
+		munmap(ptr, mapped);
+	});
+}
+
+#endif
+
+}
+
+/**
+ * \brief Returns number of online NUMA nodes
+ *
+ * \return Number of nodes (1 on machines without NUMA or other systems than Linux)
+*/
+inline int numa_nodes()
+{
+	return static_cast<int>(detail::numa_node_ids().size());
+}
+
+/**
+ * \brief Interface of memory resources used to allocate memory blocks of matrices
+ *
+ * Memory resource may be installed for current thread with mn::memory_scope.
+ * Every memory block allocated from resource is returned to it by
+ * deallocate when last matrix using it is destroyed, so resource has to
+ * outlive such matrices.
+*/
+class memory_resource
+{
+public:
+	virtual ~memory_resource() {}
+
+	/**
+	 * \brief Allocates memory
+	 *
+	 * \param bytes Number of bytes
+	 * \param alignment Alignment of memory (power of two)
+	 * \return Pointer to allocated memory
+	*/
+	virtual void* allocate(std::size_t bytes, std::size_t alignment) = 0;
+
+	/**
+	 * \brief Deallocates memory allocated with allocate
+	 *
+	 * \param ptr Pointer returned by allocate
+	 * \param bytes Number of bytes passed to allocate
+	 * \param alignment Alignment passed to allocate
+	*/
+	virtual void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) = 0;
+};
+
+/**
+ * \brief Monotonic arena of memory
+ *
+ * Memory is taken from large chunks by advancing pointer, deallocate does
+ * nothing and all chunks are released at once by release() or destructor.
+ * It makes temporaries of arithmetic operations almost free when arena is
+ * installed around computation with mn::memory_scope. Matrices allocated
+ * from arena must not be used after it is released. Arena is not
+ * thread-safe, so it should be installed by single thread only.
+*/
+class arena : public memory_resource
+{
+	std::vector<std::pair<char*, std::size_t>> chunks;
+	char* current;
+	std::size_t left;
+	std::size_t next_chunk;
+	std::size_t used_bytes;
+
+	arena(const arena&) = delete;
+	arena& operator=(const arena&) = delete;
+public:
+	/**
+	 * \brief Constructor with size of first chunk
+	 *
+	 * Chunks are allocated when needed, every next one twice as large as previous.
+	 *
+	 * \param chunk_bytes Size of first chunk
+	*/
+	explicit arena(std::size_t chunk_bytes = std::size_t(1) << 20) :
+		current(nullptr), left(0), next_chunk(std::max<std::size_t>(chunk_bytes, 64)), used_bytes(0)
+	{
+	}
+
+	~arena()
+	{
+		release();
+	}
+
+	/**
+	 * \brief Allocates memory from current chunk, or from new one if it does not fit
+	*/
+	void* allocate(std::size_t bytes, std::size_t alignment) override
+	{
+		std::size_t pad = (alignment - reinterpret_cast<std::uintptr_t>(current) % alignment) % alignment;
+		if (current == nullptr || pad + bytes > left)
+		{
+			std::size_t size = std::max(next_chunk, bytes + alignment);
+			current = static_cast<char*>(::operator new(size));
+			chunks.push_back(std::make_pair(current, size));
+			left = size;
+			next_chunk = 2 * next_chunk;
+			pad = (alignment - reinterpret_cast<std::uintptr_t>(current) % alignment) % alignment;
+		}
+		void* ptr = current + pad;
+		current += pad + bytes;
+		left -= pad + bytes;
+		used_bytes += bytes;
+		return ptr;
+	}
+
+	/**
+	 * \brief Does nothing, memory is released with whole arena
+	*/
+	void deallocate(void*, std::size_t, std::size_t) override
+	{
+	}
+
+	/**
+	 * \brief Releases all chunks
+	*/
+	void release()
+	{
+		for (auto& chunk : chunks)
+			::operator delete(chunk.first);
+		chunks.clear();
+		current = nullptr;
+		left = 0;
+		used_bytes = 0;
+	}
+
+	/**
+	 * \brief Returns number of bytes allocated since arena was created or released
+	*/
+	std::size_t used() const
+	{
+		return used_bytes;
+	}
+};
+
+namespace detail {
+
+/**
+ * \brief Returns memory resource of current thread (null for default allocation)
+*/
+inline memory_resource*& current_resource()
+{
+	static thread_local memory_resource* resource = nullptr;
+	return resource;
+}
+
+/**
+ * \brief Standard allocator drawing memory from memory resource
+ *
+ * Used for control blocks of shared pointers, so that no other memory
+ * than resource's is allocated for memory block of matrix.
+*/
+template<typename U>
+struct resource_allocator
+{
+	typedef U value_type; //!< Type of allocated objects
+	memory_resource* resource; //!< Source of memory
+
+	explicit resource_allocator(memory_resource* resource) : resource(resource) {} //!< Constructor with resource
+	template<typename V>
+	resource_allocator(const resource_allocator<V>& a) : resource(a.resource) {} //!< Converting constructor
+	U* allocate(std::size_t n) { return static_cast<U*>(resource->allocate(n * sizeof(U), alignof(U))); } //!< Allocates n objects
+	void deallocate(U* ptr, std::size_t n) { resource->deallocate(ptr, n * sizeof(U), alignof(U)); } //!< Deallocates n objects
+	template<typename V>
+	bool operator==(const resource_allocator<V>& a) const { return resource == a.resource; } //!< Compares resources
+	template<typename V>
+	bool operator!=(const resource_allocator<V>& a) const { return resource != a.resource; } //!< Compares resources
+};
+
+/**
+ * \brief Allocates memory block of n elements from memory resource
+ *
+ * Elements are default-initialized, like with new T[].
+*/
+template<typename T>
+inline std::shared_ptr<T> allocate_from(memory_resource* resource, std::size_t n)
+{
+	const std::size_t alignment = std::max<std::size_t>(alignof(T), 64);
+	std::size_t bytes = std::max<std::size_t>(n, 1) * sizeof(T);
+	T* ptr = static_cast<T*>(resource->allocate(bytes, alignment));
+	std::size_t constructed = 0;
+	try
+	{
+		for (; constructed < std::max<std::size_t>(n, 1); ++constructed)
+			new (ptr + constructed) T;
+	}
+	catch (...)
+	{
+		while (constructed > 0)
+			ptr[--constructed].~T();
+		resource->deallocate(ptr, bytes, alignment);
+		throw;
+	}
+	return std::shared_ptr<T>(ptr, [resource, bytes, alignment](T* p)
+	{
+		if (!std::is_trivially_destructible<T>::value)
+		{
+			for (std::size_t i = 0; i < bytes / sizeof(T); ++i)
+				p[i].~T();
+		}
+		resource->deallocate(p, bytes, alignment);
+	}, resource_allocator<T>(resource));
+}
+
+}
+
+/**
+ * \brief Installs memory resource for current thread within scope
+ *
+ * All memory blocks of matrices created by current thread while object
+ * exists (including temporaries of operators, copy() and det()) are
+ * allocated from resource, e.g.
+ *
+ *     mn::arena a;
+ *     {
+ *         mn::memory_scope scope(a);
+ *         auto r = (m1 + m2) * m3;
+ *     }
+ *
+ * Previous resource is restored by destructor. Null pointer restores
+ * default allocation.
+*/
+class memory_scope
+{
+	memory_resource* previous;
+
+	memory_scope(const memory_scope&) = delete;
+	memory_scope& operator=(const memory_scope&) = delete;
+public:
+	explicit memory_scope(memory_resource& resource) : previous(detail::current_resource()) { detail::current_resource() = &resource; } //!< Installs resource
+	explicit memory_scope(memory_resource* resource) : previous(detail::current_resource()) { detail::current_resource() = resource; } //!< Installs resource (or default allocation if null)
+	~memory_scope() { detail::current_resource() = previous; } //!< Restores previous resource
+};
+
+/**
+ * \brief Returns statistics of huge page allocation
+ *
+ * Pages backing blocks which are still allocated are counted now, reading
+ * /proc/self/smaps once, so this function should not be called in hot loops.
+ *
+ * \return Totals for all memory blocks allocated with huge pages requested
+*/
+inline huge_page_stats huge_page_statistics()
+{
+	std::atomic<std::size_t>* c = detail::huge_page_counters();
+	huge_page_stats stats = { c[0].load(), c[1].load(), c[2].load(), 0, 0 };
+#if defined(__linux__)
+	std::vector<std::pair<std::uintptr_t, std::pair<std::size_t, bool>>> blocks;
+	{
+		detail::huge_page_blocks& registry = detail::huge_page_blocks::instance();
+		std::lock_guard<std::mutex> guard(registry.lock);
+		blocks.assign(registry.blocks.begin(), registry.blocks.end());
+	}
+	if (blocks.empty())
+		return stats;
+	const std::size_t page = detail::huge_page_size();
+	const auto mappings = detail::anon_huge_mappings();
+	for (const auto& block : blocks)
+	{
+		std::size_t pages = block.second.first / page;
+		stats.live_pages += pages;
+		stats.obtained_pages += block.second.second ? pages : detail::transparent_huge_pages(mappings, block.first, block.second.first);
+	}
+#endif
+	return stats;
+}
+
+/**
+ * \brief Allocates memory block for matrix of specified size
+ *
+ * Number of elements is calculated in std::ptrdiff_t, so blocks larger
+ * than 2^31 elements may be allocated. Large blocks are placed on NUMA
+ * nodes according to mn::numa_config and backed by huge pages according
+ * to mn::huge_page_config, unless memory resource is installed for current
+ * thread with mn::memory_scope.
+ *
+ * \param rows Number of rows
+ * \param cols Number of columns
+ * \return Shared pointer to uninitialized memory block
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline std::shared_ptr<T> matrix<T>::allocate(int rows, int cols)
+{
+	if (rows < 0 || cols < 0)
+		throw matrix_exception("invalid dimensions");
+	if (cols != 0 && rows > std::numeric_limits<std::ptrdiff_t>::max() / static_cast<std::ptrdiff_t>(sizeof(T)) / cols)
+		throw matrix_exception("matrix too large");
+	std::size_t n = static_cast<std::size_t>(rows) * static_cast<std::size_t>(cols);
+	if (memory_resource* resource = detail::current_resource())
+		return detail::allocate_from<T>(resource, n);
+#if defined(__linux__)
+	if (std::is_trivially_copyable<T>::value && std::is_trivially_destructible<T>::value)
+	{
+		const numa_settings& numa = numa_config();
+		const huge_page_settings& huge = huge_page_config();
+		std::size_t bytes = n * sizeof(T);
+		numa_policy policy = bytes >= std::max<std::size_t>(numa.min_bytes, 1) && numa_nodes() > 1 ? numa.policy : numa_policy::first_touch;
+		huge_page_mode pages = bytes >= std::max<std::size_t>(huge.min_bytes, 1) ? huge.mode : huge_page_mode::none;
+		if (policy != numa_policy::first_touch || pages != huge_page_mode::none)
+			return detail::allocate_pages<T>(rows, cols, policy, pages);
+	}
+#endif
+	return std::shared_ptr<T>(new T[n > 0 ? n : 1], [](T* ptr) { delete[] ptr; });
+}
+
+}
@@ -20,45 +20,12 @@
 
 #pragma once
 
+#include <cmath>
+
 #include "matrix_exception.h"
 
 namespace mn {
 
-/**
- * \brief Compares two matrices
- *
- * Returns true if two matrices are equal (are of the same size and contain the same elements).
- *
- * \param m Second matrix to compare
- * \return True if equal
-*/
-template<typename T>
-inline bool matrix<T>::operator==(const matrix<T>& m) const
-{
-	if (rows() != m.rows() || cols() != m.cols())
-		return false;
-	for (auto i1 = begin(), i2 = m.begin(); i1 != end() && i2 != m.end(); ++i1, ++i2)
-	{
-		if (*i1 != *i2)
-			return false;
-	}
-	return true;
-}
-
-/**
- * \brief Compares two matrices if they are not equal
- *
- * Returns true if two matrices are not equal (are of different size or contain different elements).
- *
- * \param m Second matrix to compare
- * \return True if not equal
-*/
-template<typename T>
-inline bool matrix<T>::operator!=(const matrix<T>& m) const
-{
-	return !operator==(m);
-}
-
 /**
  * \brief Adds two matrices
  *
@@ -94,7 +61,8 @@ inline matrix<T> matrix<T>::operator+(const T& value) const
 /**
  * \brief Adds another matrix to current
  *
- * Adds matrix to current without allocating memory.
+ * Adds matrix to current without allocating memory. Elements of
+ * reduced precision are added in float (see mn::detail::combine).
  *
  * \param m Matrix to add to current
  * \return Reference to modified matrix
@@ -103,12 +71,9 @@ inline matrix<T> matrix<T>::operator+(const T& value) const
 template<typename T>
 inline matrix<T>& matrix<T>::operator+=(const matrix<T>& m)
 {
-	if (rows() != m.rows() || cols() != m.cols())
-		throw matrix_exception("dimensions mismatch");
-	auto i1 = begin();
-	auto i2 = m.begin();
-	while (i1 != end() && i2 != m.end())
-		*i1++ += *i2++;
+	detail::require_same_size(*this, m);
+	typedef accumulator_t<T> A;
+	detail::combine(*this, m, *this, [](A x, A y) { return x + y; });
 	return *this;
 }
 
@@ -123,8 +88,9 @@ inline matrix<T>& matrix<T>::operator+=(const matrix<T>& m)
 template<typename T>
 inline matrix<T>& matrix<T>::operator+=(const T& value)
 {
-	for (auto i = begin(); i != end(); ++i)
-		*i += value;
+	typedef accumulator_t<T> A;
+	A v = static_cast<A>(value);
+	detail::apply(*this, *this, [v](A x) { return x + v; });
 	return *this;
 }
 
@@ -163,7 +129,8 @@ inline matrix<T> matrix<T>::operator-(const T& value) const
 /**
  * \brief Subtracts another matrix from current
  *
- * Subtracts matrix from current without allocating memory.
+ * Subtracts matrix from current without allocating memory. Elements
+ * of reduced precision are subtracted in float (see mn::detail::combine).
  *
  * \param m Matrix to subtract from current
  * \return Reference to modified matrix
@@ -172,12 +139,9 @@ inline matrix<T> matrix<T>::operator-(const T& value) const
 template<typename T>
 inline matrix<T>& matrix<T>::operator-=(const matrix<T>& m)
 {
-	if (rows() != m.rows() || cols() != m.cols())
-		throw matrix_exception("dimensions mismatch");
-	auto i1 = begin();
-	auto i2 = m.begin();
-	while (i1 != end() && i2 != m.end())
-		*i1++ -= *i2++;
+	detail::require_same_size(*this, m);
+	typedef accumulator_t<T> A;
+	detail::combine(*this, m, *this, [](A x, A y) { return x - y; });
 	return *this;
 }
 
@@ -192,15 +156,19 @@ inline matrix<T>& matrix<T>::operator-=(const matrix<T>& m)
 template<typename T>
 inline matrix<T>& matrix<T>::operator-=(const T& value)
 {
-	for (auto i = begin(); i != end(); ++i)
-		*i -= value;
+	typedef accumulator_t<T> A;
+	A v = static_cast<A>(value);
+	detail::apply(*this, *this, [v](A x) { return x - v; });
 	return *this;
 }
 
 /**
  * \brief Multiplies two matrices
  *
- * Allocates new matrix containing product of two matrices.
+ * Allocates new matrix containing product of two matrices. Products with
+ * vectors are delegated to mn::gemv, all the others to mn::gemm. Very large
+ * products are computed with mn::strassen if it is enabled in
+ * mn::strassen_config() (disabled by default).
  *
  * \param m Matrix to right-hand-side multiply with current
  * \return New matrix containing product
@@ -212,16 +180,21 @@ inline matrix<T> matrix<T>::operator*(const matrix<T>& m) const
 	if (cols() != m.rows())
 		throw matrix_exception("dimensions mismatch");
 	matrix<T> product(rows(), m.cols());
-	for (int row = 0; row < product.rows(); ++row)
+	if (m.cols() == 1)
 	{
-		for (int col = 0; col < product.cols(); ++col)
-		{
-			T sum = 0;
-			for (int i = 0; i < cols(); ++i)
-				sum += (*this)[row][i] * m[i][col];
-			product[row][col] = sum;
-		}
+		gemv(T(1), *this, m, T(0), product);
+		return product;
+	}
+	if (rows() == 1)
+	{
+		gemv(T(1), m, *this, T(0), product, transposition::transposed);
+		return product;
 	}
+	const strassen_settings& fast = strassen_config();
+	if (fast.enabled && std::min(std::min(rows(), cols()), m.cols()) >= fast.cutoff)
+		strassen(*this, m, product);
+	else
+		gemm(T(1), *this, m, T(0), product);
 
 	return product;
 }
@@ -253,8 +226,9 @@ inline matrix<T> matrix<T>::operator*(const T& value) const
 template<typename T>
 inline matrix<T>& matrix<T>::operator*=(const T& value)
 {
-	for (auto i = begin(); i != end(); ++i)
-		*i *= value;
+	typedef accumulator_t<T> A;
+	A v = static_cast<A>(value);
+	detail::apply(*this, *this, [v](A x) { return x * v; });
 	return *this;
 }
 
@@ -288,8 +262,9 @@ inline matrix<T>& matrix<T>::operator/=(const T& value)
 {
 	if (value == 0)
 		throw matrix_exception("divide by zero");
-	for (auto i = begin(); i != end(); ++i)
-		*i /= value;
+	typedef accumulator_t<T> A;
+	A v = static_cast<A>(value);
+	detail::apply(*this, *this, [v](A x) { return x / v; });
 	return *this;
 }
 
@@ -324,7 +299,7 @@ inline T matrix<T>::det() const
 				++submatrix_col;
 			}
 		}
-		determinant += (*this)[0][col] * pow(-1.0, 2.0 + col) * submatrix.det();
+		determinant += (*this)[0][col] * std::pow(-1.0, 2.0 + col) * submatrix.det();
 	}
 	return determinant;
 }
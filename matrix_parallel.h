@@ -0,0 +1,348 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mn {
+
+/**
+ * \brief Minimal number of elements processed by single parallel task
+ *
+ * Kernels split their work into tasks touching at least this number of
+ * elements. Smaller problems are processed serially by calling thread.
+*/
+static const int parallel_min_work = 1 << 15;
+
+/**
+ * \brief mn::thread_pool
+ *
+ * Pool of worker threads used by all parallel kernels of the library.
+ * Work is submitted as a job consisting of numbered tasks. Calling thread
+ * takes part in processing its own job, so jobs may be safely submitted
+ * from inside other jobs (nested parallelism never deadlocks).
+*/
+class thread_pool
+{
+public:
+	explicit thread_pool(int threads);
+	~thread_pool();
+
+	static thread_pool& instance();
+
+	int size() const;
+	void resize(int threads);
+	void run(int tasks, const std::function<void(int)>& task);
+private:
+	struct job;
+
+	void start(int workers_n);
+	void stop();
+	void worker();
+	bool execute(job& j);
+
+	std::vector<std::thread> workers;
+	std::deque<std::shared_ptr<job>> jobs;
+	std::mutex mutex;
+	std::condition_variable job_cv;
+	std::condition_variable done_cv;
+	bool stopping;
+};
+
+/**
+ * \brief mn::thread_pool::job
+ *
+ * Describes single job submitted to the pool: task function, number
+ * of tasks and counters of claimed and finished tasks.
+*/
+struct thread_pool::job
+{
+	/**
+	 * \brief Constructor with number of tasks and task function
+	 *
+	 * \param tasks Number of tasks
+	 * \param task Function called with task index
+	*/
+	job(int tasks, const std::function<void(int)>& task) :
+		tasks(tasks), task(task), next(0), done(0) {}
+
+	const int tasks; //!< Number of tasks in job
+	const std::function<void(int)>& task; //!< Task function
+	std::atomic<int> next; //!< Index of next unclaimed task
+	std::atomic<int> done; //!< Number of finished tasks
+	std::exception_ptr error; //!< First exception thrown by any task
+};
+
+/**
+ * \brief Constructor with number of threads
+ *
+ * Creates pool able to process jobs with specified number of threads,
+ * including calling thread (i.e. threads - 1 workers are started).
+ *
+ * \param threads Number of threads
+*/
+inline thread_pool::thread_pool(int threads) :
+	stopping(false)
+{
+	start(threads - 1);
+}
+
+/**
+ * \brief Destructor
+ *
+ * Stops and joins all worker threads.
+*/
+inline thread_pool::~thread_pool()
+{
+	stop();
+}
+
+/**
+ * \brief Returns global thread pool
+ *
+ * Global pool is created on first use with number of threads equal to
+ * number of hardware threads.
+ *
+ * \return Reference to global thread pool
+*/
+inline thread_pool& thread_pool::instance()
+{
+	static thread_pool pool(std::max(1, static_cast<int>(std::thread::hardware_concurrency())));
+	return pool;
+}
+
+/**
+ * \brief Returns number of threads processing jobs (including calling thread)
+ *
+ * \return Number of threads
+*/
+inline int thread_pool::size() const
+{
+	return static_cast<int>(workers.size()) + 1;
+}
+
+/**
+ * \brief Changes number of threads
+ *
+ * Must not be called while any job is being processed.
+ *
+ * \param threads Number of threads (including calling thread)
+*/
+inline void thread_pool::resize(int threads)
+{
+	stop();
+	start(threads - 1);
+}
+
+/**
+ * \brief Runs job and waits for its completion
+ *
+ * Calls task function for every task index in range [0, tasks). Tasks are
+ * distributed dynamically between calling thread and workers. If any task
+ * throws, the first exception is rethrown after all tasks finish.
+ *
+ * \param tasks Number of tasks
+ * \param task Function called with task index
+*/
+inline void thread_pool::run(int tasks, const std::function<void(int)>& task)
+{
+	if (tasks <= 0)
+		return;
+	if (tasks == 1 || workers.empty())
+	{
+		for (int i = 0; i < tasks; ++i)
+			task(i);
+		return;
+	}
+
+	auto j = std::make_shared<job>(tasks, task);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(j);
+	}
+	job_cv.notify_all();
+
+	while (execute(*j))
+		;
+
+	std::unique_lock<std::mutex> lock(mutex);
+	auto queued = std::find(jobs.begin(), jobs.end(), j);
+	if (queued != jobs.end())
+		jobs.erase(queued);
+	done_cv.wait(lock, [&j] { return j->done == j->tasks; });
+	if (j->error)
+		std::rethrow_exception(j->error);
+}
+
+/**
+ * \brief Starts specified number of worker threads
+*/
+inline void thread_pool::start(int workers_n)
+{
+	stopping = false;
+	for (int i = 0; i < workers_n; ++i)
+		workers.emplace_back(&thread_pool::worker, this);
+}
+
+/**
+ * \brief Stops and joins all worker threads
+*/
+inline void thread_pool::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	job_cv.notify_all();
+	for (auto& w : workers)
+		w.join();
+	workers.clear();
+}
+
+/**
+ * \brief Main loop of worker thread
+*/
+inline void thread_pool::worker()
+{
+	for (;;)
+	{
+		std::shared_ptr<job> j;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			job_cv.wait(lock, [this] { return stopping || !jobs.empty(); });
+			if (stopping)
+				return;
+			j = jobs.front();
+		}
+		if (!execute(*j))
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (!jobs.empty() && jobs.front() == j)
+				jobs.pop_front();
+		}
+	}
+}
+
+/**
+ * \brief Claims and executes single task of job
+ *
+ * \return False if all tasks of job are already claimed
+*/
+inline bool thread_pool::execute(job& j)
+{
+	int index = j.next++;
+	if (index >= j.tasks)
+		return false;
+	try
+	{
+		j.task(index);
+	}
+	catch (...)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!j.error)
+			j.error = std::current_exception();
+	}
+	if (++j.done == j.tasks)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		done_cv.notify_all();
+	}
+	return true;
+}
+
+/**
+ * \brief Sets number of threads used by parallel kernels
+ *
+ * \param threads Number of threads (including calling thread)
+*/
+inline void set_num_threads(int threads)
+{
+	thread_pool::instance().resize(std::max(1, threads));
+}
+
+/**
+ * \brief Returns number of threads used by parallel kernels
+ *
+ * \return Number of threads (including calling thread)
+*/
+inline int get_num_threads()
+{
+	return thread_pool::instance().size();
+}
+
+/**
+ * \brief Returns minimal number of rows processed by single task
+ *
+ * \param work_per_row Number of elements touched per single row
+ * \return Number of rows per task
+*/
+inline int parallel_grain(long long work_per_row)
+{
+	if (work_per_row < 1)
+		work_per_row = 1;
+	return static_cast<int>(std::max(1LL, parallel_min_work / work_per_row));
+}
+
+/**
+ * \brief Processes range of indexes in parallel
+ *
+ * Splits range [first, last) into chunks containing at least grain indexes
+ * and calls fn(chunk_begin, chunk_end) for each of them using global thread
+ * pool. Small ranges are processed by calling thread only.
+ *
+ * \param first First index of range
+ * \param last Index after the last in range
+ * \param grain Minimal number of indexes in single chunk
+ * \param fn Function called for each chunk
+*/
+template<typename F>
+inline void parallel_for(int first, int last, int grain, F fn)
+{
+	int n = last - first;
+	if (n <= 0)
+		return;
+	if (grain < 1)
+		grain = 1;
+	int chunks = std::min((n + grain - 1) / grain, 4 * get_num_threads());
+	if (chunks <= 1)
+	{
+		fn(first, last);
+		return;
+	}
+	thread_pool::instance().run(chunks, [&](int chunk)
+	{
+		int chunk_begin = first + static_cast<int>(static_cast<long long>(n) * chunk / chunks);
+		int chunk_end = first + static_cast<int>(static_cast<long long>(n) * (chunk + 1) / chunks);
+		fn(chunk_begin, chunk_end);
+	});
+}
+
+}
@@ -0,0 +1,347 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include "matrix_memory.h"
+
+namespace mn {
+
+/**
+ * \brief Statistics of buffer pool
+*/
+struct pool_stats
+{
+	std::size_t hits; //!< Number of allocations served from cached buffers
+	std::size_t misses; //!< Number of allocations which had to allocate new buffer
+	std::size_t cached_bytes; //!< Number of bytes in buffers cached by all threads
+};
+
+/**
+ * \brief Pool recycling memory buffers of the same size classes
+ *
+ * Sizes of buffers are rounded up to size classes (four classes between
+ * consecutive powers of two, so at most 25% of memory is wasted). Released
+ * buffers are cached by thread releasing them and reused by next
+ * allocation of the same class on this thread, so the fast path does not
+ * take any locks. Pool is installed for current thread with
+ * mn::memory_scope, e.g. mn::memory_scope scope(mn::buffer_pool::instance()),
+ * and then serves both memory blocks of matrices and control blocks of
+ * their shared pointers. Buffers cached by thread are freed when thread
+ * exits, when trim() is called or when they exceed limit. Statistics are
+ * counted by every thread separately and summed by stats().
+*/
+class buffer_pool : public memory_resource
+{
+public:
+	static buffer_pool& instance();
+
+	void* allocate(std::size_t bytes, std::size_t alignment) override;
+	void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) override;
+
+	void trim();
+	void set_limit(std::size_t bytes);
+	std::size_t limit() const;
+	pool_stats stats() const;
+
+	static const std::size_t alignment = 64; //!< Alignment of every pooled buffer
+	static const int classes = 256; //!< Number of size classes
+private:
+	struct cache;
+
+	buffer_pool();
+
+	static int size_class(std::size_t bytes);
+	static std::size_t class_size(int index);
+	static void* allocate_aligned(std::size_t bytes);
+	static void free_aligned(void* ptr);
+	static cache* local_cache();
+
+	std::atomic<std::size_t> max_cached;
+	mutable std::mutex caches_lock; //!< Guards caches and counters of exited threads
+	std::vector<cache*> caches; //!< Caches of running threads
+	std::size_t exited_hits; //!< Hits counted by threads which exited
+	std::size_t exited_misses; //!< Misses counted by threads which exited
+};
+
+/**
+ * \brief mn::buffer_pool::cache
+ *
+ * Lists of free buffers of every size class cached by single thread.
+ * Counters are modified only by owning thread, without read-modify-write
+ * operations, and may be read by other threads.
+*/
+struct buffer_pool::cache
+{
+	std::vector<void*> lists[classes]; //!< Free buffers of every size class
+	std::atomic<std::size_t> bytes; //!< Number of bytes in cached buffers
+	std::atomic<std::size_t> hits; //!< Number of allocations served from cached buffers
+	std::atomic<std::size_t> misses; //!< Number of allocations which had to allocate new buffer
+
+	cache();
+	~cache();
+
+	void release(); //!< Frees all cached buffers
+
+	/**
+	 * \brief Adds value to counter owned by current thread
+	*/
+	static void add(std::atomic<std::size_t>& counter, std::size_t value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+};
+
+/**
+ * \brief Returns global buffer pool
+ *
+ * \return Reference to pool
+*/
+inline buffer_pool& buffer_pool::instance()
+{
+	static buffer_pool pool;
+	return pool;
+}
+
+/**
+ * \brief Default constructor
+ *
+ * Every thread may cache up to 256 MB of buffers by default.
+*/
+inline buffer_pool::buffer_pool() :
+	max_cached(std::size_t(1) << 28), exited_hits(0), exited_misses(0)
+{
+}
+
+/**
+ * \brief Returns index of size class of buffer
+*/
+inline int buffer_pool::size_class(std::size_t bytes)
+{
+	if (bytes <= 64)
+		return 0;
+	std::size_t x = bytes - 1;
+	int e = 4;
+	while ((x >> e) > 7)
+		++e;
+	return 4 * (e - 4) + static_cast<int>(x >> e) - 3;
+}
+
+/**
+ * \brief Returns size of buffers of size class
+*/
+inline std::size_t buffer_pool::class_size(int index)
+{
+	if (index == 0)
+		return 64;
+	int e = (index - 1) / 4 + 4;
+	return (static_cast<std::size_t>((index - 1) % 4) + 5) << e;
+}
+
+/**
+ * \brief Allocates buffer aligned to buffer_pool::alignment
+ *
+ * Pointer returned by operator new is stored just before aligned buffer.
+*/
+inline void* buffer_pool::allocate_aligned(std::size_t bytes)
+{
+	char* raw = static_cast<char*>(::operator new(bytes + alignment + sizeof(void*)));
+	char* aligned = raw + sizeof(void*);
+	aligned += (alignment - reinterpret_cast<std::uintptr_t>(aligned) % alignment) % alignment;
+	reinterpret_cast<void**>(aligned)[-1] = raw;
+	return aligned;
+}
+
+/**
+ * \brief Frees buffer allocated with allocate_aligned
+*/
+inline void buffer_pool::free_aligned(void* ptr)
+{
+	::operator delete(static_cast<void**>(ptr)[-1]);
+}
+
+/**
+ * \brief Returns cache of current thread or null if thread is exiting
+*/
+inline buffer_pool::cache* buffer_pool::local_cache()
+{
+	static thread_local bool destroyed = false;
+	static thread_local struct holder
+	{
+		cache c;
+		~holder() { destroyed = true; }
+	} local;
+	return destroyed ? nullptr : &local.c;
+}
+
+/**
+ * \brief Registers cache of new thread in pool
+*/
+inline buffer_pool::cache::cache() :
+	bytes(0), hits(0), misses(0)
+{
+	buffer_pool& pool = instance();
+	std::lock_guard<std::mutex> guard(pool.caches_lock);
+	pool.caches.push_back(this);
+}
+
+/**
+ * \brief Frees all cached buffers at thread exit and keeps its counters in pool
+*/
+inline buffer_pool::cache::~cache()
+{
+	release();
+	buffer_pool& pool = instance();
+	std::lock_guard<std::mutex> guard(pool.caches_lock);
+	pool.exited_hits += hits.load(std::memory_order_relaxed);
+	pool.exited_misses += misses.load(std::memory_order_relaxed);
+	pool.caches.erase(std::find(pool.caches.begin(), pool.caches.end(), this));
+}
+
+/**
+ * \brief Frees all buffers cached by thread
+*/
+inline void buffer_pool::cache::release()
+{
+	for (std::vector<void*>& list : lists)
+	{
+		for (void* ptr : list)
+			free_aligned(ptr);
+		list.clear();
+	}
+	bytes.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * \brief Allocates buffer, reusing cached one of the same size class if available
+ *
+ * \param bytes Number of bytes
+ * \param align Alignment of memory (buffers are aligned to 64 bytes, larger alignment is not supported)
+ * \return Pointer to buffer
+ * \throws std::bad_alloc
+*/
+inline void* buffer_pool::allocate(std::size_t bytes, std::size_t align)
+{
+	int index = size_class(bytes);
+	if (align > alignment || index >= classes)
+		throw std::bad_alloc();
+	cache* c = local_cache();
+	if (c != nullptr && !c->lists[index].empty())
+	{
+		void* ptr = c->lists[index].back();
+		c->lists[index].pop_back();
+		cache::add(c->bytes, std::size_t(0) - class_size(index));
+		cache::add(c->hits, 1);
+		return ptr;
+	}
+	if (c != nullptr)
+		cache::add(c->misses, 1);
+	else
+	{
+		std::lock_guard<std::mutex> guard(caches_lock);
+		++exited_misses;
+	}
+	return allocate_aligned(class_size(index));
+}
+
+/**
+ * \brief Returns buffer to cache of current thread
+ *
+ * Buffer is freed instead if cache would exceed limit.
+ *
+ * \param ptr Pointer returned by allocate
+ * \param bytes Number of bytes passed to allocate
+*/
+inline void buffer_pool::deallocate(void* ptr, std::size_t bytes, std::size_t)
+{
+	int index = size_class(bytes);
+	std::size_t size = class_size(index);
+	cache* c = local_cache();
+	if (c == nullptr || c->bytes.load(std::memory_order_relaxed) + size > max_cached.load(std::memory_order_relaxed))
+	{
+		free_aligned(ptr);
+		return;
+	}
+	c->lists[index].push_back(ptr);
+	cache::add(c->bytes, size);
+}
+
+/**
+ * \brief Frees all buffers cached by current thread
+*/
+inline void buffer_pool::trim()
+{
+	if (cache* c = local_cache())
+		c->release();
+}
+
+/**
+ * \brief Sets maximal number of bytes cached by every thread
+ *
+ * Buffers released over limit are freed immediately. Current caches are
+ * not trimmed.
+ *
+ * \param bytes Limit (0 disables caching)
+*/
+inline void buffer_pool::set_limit(std::size_t bytes)
+{
+	max_cached = bytes;
+}
+
+/**
+ * \brief Returns maximal number of bytes cached by every thread
+ *
+ * \return Limit
+*/
+inline std::size_t buffer_pool::limit() const
+{
+	return max_cached;
+}
+
+/**
+ * \brief Returns statistics of pool
+ *
+ * Sums counters of all threads. Counters of running threads may be read
+ * slightly out of date.
+ *
+ * \return Numbers of hits and misses since start of program and size of cached buffers
+*/
+inline pool_stats buffer_pool::stats() const
+{
+	std::lock_guard<std::mutex> guard(caches_lock);
+	pool_stats s = { exited_hits, exited_misses, 0 };
+	for (const cache* c : caches)
+	{
+		s.hits += c->hits.load(std::memory_order_relaxed);
+		s.misses += c->misses.load(std::memory_order_relaxed);
+		s.cached_bytes += c->bytes.load(std::memory_order_relaxed);
+	}
+	return s;
+}
+
+}
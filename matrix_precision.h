@@ -0,0 +1,430 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <type_traits>
+
+#if defined(__F16C__) || defined(__AVX2__) || defined(__AVX512BF16__)
+#include <immintrin.h>
+#endif
+
+#include "matrix_parallel.h"
+
+namespace mn {
+
+/**
+ * \brief mn::bfloat16
+ *
+ * Storage type for brain floating point numbers (8 bits of exponent,
+ * 7 bits of mantissa). Halves memory usage of float matrices, keeping
+ * their range. Arithmetic is performed after conversion to float.
+*/
+class bfloat16
+{
+public:
+	bfloat16() : bits(0) {} //!< Default constructor
+
+	/**
+	 * \brief Constructor with float value
+	 *
+	 * Value is rounded to nearest representable number (ties to even).
+	 *
+	 * \param value Float value
+	*/
+	bfloat16(float value) : bits(from_float(value)) {}
+
+	/**
+	 * \brief Converts number to float
+	*/
+	operator float() const
+	{
+		std::uint32_t u = static_cast<std::uint32_t>(bits) << 16;
+		float value;
+		std::memcpy(&value, &u, sizeof(value));
+		return value;
+	}
+
+	bfloat16& operator+=(float value) { return *this = float(*this) + value; } //!< Adds value
+	bfloat16& operator-=(float value) { return *this = float(*this) - value; } //!< Subtracts value
+	bfloat16& operator*=(float value) { return *this = float(*this) * value; } //!< Multiplies by value
+	bfloat16& operator/=(float value) { return *this = float(*this) / value; } //!< Divides by value
+
+	/**
+	 * \brief Converts float to bits of bfloat16 number
+	*/
+	static std::uint16_t from_float(float value)
+	{
+		std::uint32_t u;
+		std::memcpy(&u, &value, sizeof(u));
+		if ((u & 0x7fffffffu) > 0x7f800000u)
+			return static_cast<std::uint16_t>((u >> 16) | 0x40);
+		u += 0x7fffu + ((u >> 16) & 1);
+		return static_cast<std::uint16_t>(u >> 16);
+	}
+
+	std::uint16_t bits; //!< Sign, exponent and mantissa bits
+};
+
+/**
+ * \brief mn::float16
+ *
+ * Storage type for IEEE 754 half precision floating point numbers
+ * (5 bits of exponent, 10 bits of mantissa). Arithmetic is performed
+ * after conversion to float.
+*/
+class float16
+{
+public:
+	float16() : bits(0) {} //!< Default constructor
+
+	/**
+	 * \brief Constructor with float value
+	 *
+	 * Value is rounded to nearest representable number (ties to even).
+	 *
+	 * \param value Float value
+	*/
+	float16(float value) : bits(from_float(value)) {}
+
+	/**
+	 * \brief Converts number to float
+	*/
+	operator float() const
+	{
+#if defined(__F16C__)
+		return _cvtsh_ss(bits);
+#else
+		std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000) << 16;
+		std::uint32_t exponent = (bits >> 10) & 0x1f;
+		std::uint32_t mantissa = bits & 0x3ff;
+		std::uint32_t u;
+		if (exponent == 0x1f)
+			u = sign | 0x7f800000u | (mantissa << 13);
+		else if (exponent != 0)
+			u = sign | ((exponent + 112) << 23) | (mantissa << 13);
+		else if (mantissa == 0)
+			u = sign;
+		else
+		{
+			// Subnormal half is normal float
+			exponent = 113;
+			while (!(mantissa & 0x400))
+			{
+				mantissa <<= 1;
+				--exponent;
+			}
+			u = sign | (exponent << 23) | ((mantissa & 0x3ff) << 13);
+		}
+		float value;
+		std::memcpy(&value, &u, sizeof(value));
+		return value;
+#endif
+	}
+
+	float16& operator+=(float value) { return *this = float(*this) + value; } //!< Adds value
+	float16& operator-=(float value) { return *this = float(*this) - value; } //!< Subtracts value
+	float16& operator*=(float value) { return *this = float(*this) * value; } //!< Multiplies by value
+	float16& operator/=(float value) { return *this = float(*this) / value; } //!< Divides by value
+
+	/**
+	 * \brief Converts float to bits of float16 number
+	*/
+	static std::uint16_t from_float(float value)
+	{
+#if defined(__F16C__)
+		return _cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT);
+#else
+		std::uint32_t u;
+		std::memcpy(&u, &value, sizeof(u));
+		std::uint16_t sign = static_cast<std::uint16_t>((u >> 16) & 0x8000);
+		std::uint32_t magnitude = u & 0x7fffffffu;
+		if (magnitude > 0x7f800000u)
+			return sign | 0x7e00;
+		if (magnitude >= 0x47800000u)
+			return sign | 0x7c00;
+		if (magnitude < 0x38800000u)
+		{
+			// Result is subnormal half (or zero)
+			int shift = 126 - static_cast<int>(magnitude >> 23);
+			if (shift > 24)
+				return sign;
+			std::uint32_t mantissa = (magnitude & 0x7fffffu) | 0x800000u;
+			std::uint32_t half = mantissa >> shift;
+			std::uint32_t rest = mantissa & ((1u << shift) - 1);
+			std::uint32_t middle = 1u << (shift - 1);
+			if (rest > middle || (rest == middle && (half & 1)))
+				++half;
+			return sign | static_cast<std::uint16_t>(half);
+		}
+		magnitude -= 0x38000000u;
+		magnitude += 0xfffu + ((magnitude >> 13) & 1);
+		return sign | static_cast<std::uint16_t>(magnitude >> 13);
+#endif
+	}
+
+	std::uint16_t bits; //!< Sign, exponent and mantissa bits
+};
+
+/**
+ * \brief Input stream operator for bfloat16 number
+*/
+inline std::istream& operator>>(std::istream& i, bfloat16& value)
+{
+	float f;
+	if (i >> f)
+		value = f;
+	return i;
+}
+
+/**
+ * \brief Input stream operator for float16 number
+*/
+inline std::istream& operator>>(std::istream& i, float16& value)
+{
+	float f;
+	if (i >> f)
+		value = f;
+	return i;
+}
+
+/**
+ * \brief mn::accumulator<T>
+ *
+ * Selects type used to accumulate sums of products of elements of type T
+ * (e.g. by mn::gemm). Reduced precision storage types are accumulated in
+ * float. May be specialized by user, or overridden per call by passing
+ * accumulator type explicitly, e.g. mn::gemm<float, double>(...).
+*/
+template<typename T>
+struct accumulator
+{
+	typedef T type; //!< Accumulator type
+};
+
+/**
+ * \brief Accumulator type of bfloat16 matrices
+*/
+template<>
+struct accumulator<bfloat16>
+{
+	typedef float type; //!< Accumulator type
+};
+
+/**
+ * \brief Accumulator type of float16 matrices
+*/
+template<>
+struct accumulator<float16>
+{
+	typedef float type; //!< Accumulator type
+};
+
+/**
+ * \brief Shorthand for accumulator type of elements of type T
+*/
+template<typename T>
+using accumulator_t = typename accumulator<T>::type;
+
+namespace detail {
+
+/**
+ * \brief Converts contiguous array of elements to another type
+*/
+template<typename S, typename D>
+inline void convert(const S* src, D* dst, int n)
+{
+	for (int i = 0; i < n; ++i)
+		dst[i] = static_cast<D>(src[i]);
+}
+
+/**
+ * \brief Converts contiguous array of float16 numbers to floats (uses F16C if available)
+*/
+inline void convert(const float16* src, float* dst, int n)
+{
+	int i = 0;
+#if defined(__F16C__)
+	for (; i + 8 <= n; i += 8)
+		_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i))));
+#endif
+	for (; i < n; ++i)
+		dst[i] = src[i];
+}
+
+/**
+ * \brief Converts contiguous array of floats to float16 numbers (uses F16C if available)
+*/
+inline void convert(const float* src, float16* dst, int n)
+{
+	int i = 0;
+#if defined(__F16C__)
+	for (; i + 8 <= n; i += 8)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT));
+#endif
+	for (; i < n; ++i)
+		dst[i] = src[i];
+}
+
+/**
+ * \brief Converts contiguous array of bfloat16 numbers to floats (uses AVX2 if available)
+*/
+inline void convert(const bfloat16* src, float* dst, int n)
+{
+	int i = 0;
+#if defined(__AVX2__)
+	for (; i + 8 <= n; i += 8)
+	{
+		__m256i wide = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)));
+		_mm256_storeu_ps(dst + i, _mm256_castsi256_ps(_mm256_slli_epi32(wide, 16)));
+	}
+#endif
+	for (; i < n; ++i)
+		dst[i] = src[i];
+}
+
+/**
+ * \brief Converts contiguous array of floats to bfloat16 numbers (uses AVX-512 BF16 if available)
+ *
+ * Note that AVX-512 BF16 instructions treat subnormal floats as zeros.
+*/
+inline void convert(const float* src, bfloat16* dst, int n)
+{
+	int i = 0;
+#if defined(__AVX512BF16__)
+	for (; i + 16 <= n; i += 16)
+	{
+		__m256bh packed = _mm512_cvtneps_pbh(_mm512_loadu_ps(src + i));
+		std::memcpy(static_cast<void*>(dst + i), &packed, sizeof(packed));
+	}
+#endif
+	for (; i < n; ++i)
+		dst[i] = src[i];
+}
+
+/**
+ * \brief Returns pointer to elements converted to type A
+ *
+ * Elements already of type A are not copied.
+*/
+template<typename T>
+inline const T* converted(const T* src, int, T*)
+{
+	return src;
+}
+
+/**
+ * \brief Returns pointer to elements converted to type A
+ *
+ * Elements are converted into temporary buffer passed as argument.
+*/
+template<typename T, typename A>
+inline const A* converted(const T* src, int n, A* tmp)
+{
+	convert(src, tmp, n);
+	return tmp;
+}
+
+/**
+ * \brief Returns pointer where results of type A for elements of type T are written
+ *
+ * Results already of type T are written directly to destination.
+*/
+template<typename T>
+inline T* conversion_target(T* dst, T*)
+{
+	return dst;
+}
+
+/**
+ * \brief Returns pointer where results of type A for elements of type T are written
+ *
+ * Results are written to temporary buffer passed as argument and stored
+ * by mn::detail::store_converted.
+*/
+template<typename T, typename A>
+inline A* conversion_target(T*, A* tmp)
+{
+	return tmp;
+}
+
+/**
+ * \brief Stores results written to conversion target (nothing to do for the same type)
+*/
+template<typename T>
+inline void store_converted(const T*, T*, int)
+{
+}
+
+/**
+ * \brief Stores results written to conversion target, converting them to type T
+*/
+template<typename A, typename T>
+inline void store_converted(const A* src, T* dst, int n)
+{
+	convert(src, dst, n);
+}
+
+/**
+ * \brief Number of elements converted to accumulator type at once by element-wise kernels
+*/
+const int convert_chunk = 256;
+
+/**
+ * \brief Returns length of chunks of rows processed by element-wise kernels
+ *
+ * Rows of elements stored in accumulator type are processed whole.
+*/
+template<typename T, typename A>
+inline int convert_chunk_size(int cols)
+{
+	return std::is_same<T, A>::value ? std::max(cols, 1) : convert_chunk;
+}
+
+}
+
+/**
+ * \brief Converts matrix to matrix of another element type
+ *
+ * Allocates new matrix and converts elements row-by-row, using vector
+ * conversion instructions for reduced precision types when available.
+ * Rows are converted in parallel.
+ *
+ * \param m Matrix to convert
+ * \return New matrix containing converted elements
+*/
+template<typename D, typename S>
+inline matrix<D> matrix_cast(const matrix<S>& m)
+{
+	matrix<D> result(m.rows(), m.cols());
+	int cols = m.cols();
+	parallel_for(0, m.rows(), parallel_grain(cols), [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+			detail::convert(m.row_data(r), result.row_data(r), cols);
+	});
+	return result;
+}
+
+}
@@ -0,0 +1,358 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#if defined(__AVX2__) || (defined(__AVX512VNNI__) && defined(__AVX512BW__))
+#include <immintrin.h>
+#endif
+
+#include "matrix_exception.h"
+#include "matrix_blas.h"
+#include "matrix_parallel.h"
+
+namespace mn {
+
+/**
+ * \brief mn::quantized_matrix<Q>
+ *
+ * Matrix of integers of type Q (e.g. std::int8_t) representing real numbers
+ * with affine quantization: real = scale * (quantized - zero_point).
+ * Values matrix is shared like any other matrix object.
+*/
+template<typename Q>
+class quantized_matrix
+{
+public:
+	/**
+	 * \brief Constructor with quantized values and quantization parameters
+	 *
+	 * \param values Matrix of quantized values
+	 * \param scale Quantization scale
+	 * \param zero_point Quantized value representing real zero
+	*/
+	quantized_matrix(const matrix<Q>& values, float scale, int zero_point) :
+		m(values), s(scale), z(zero_point) {}
+
+	int rows() const { return m.rows(); } //!< Returns number of rows
+	int cols() const { return m.cols(); } //!< Returns number of columns
+	matrix<Q>& values() { return m; } //!< Returns matrix of quantized values
+	const matrix<Q>& values() const { return m; } //!< Returns matrix of quantized values
+	float scale() const { return s; } //!< Returns quantization scale
+	int zero_point() const { return z; } //!< Returns quantized value representing real zero
+protected:
+	matrix<Q> m; //!< Quantized values
+	float s; //!< Quantization scale
+	int z; //!< Zero point
+};
+
+/**
+ * \brief Quantizes matrix with specified parameters
+ *
+ * Values are rounded to nearest integer and saturated to symmetric range
+ * [-max, max] of type Q (e.g. [-127, 127] for std::int8_t), which is
+ * required by vectorized int8 kernels. Rows are quantized in parallel.
+ * Elements of type T are converted to float first.
+ *
+ * \param m Matrix to quantize
+ * \param scale Quantization scale
+ * \param zero_point Quantized value representing real zero
+ * \return Quantized matrix
+*/
+template<typename Q, typename T>
+inline quantized_matrix<Q> quantize(const matrix<T>& m, float scale, int zero_point)
+{
+	const float q_max = static_cast<float>(std::numeric_limits<Q>::max());
+	const float inverse = 1.0f / scale;
+	const float shift = static_cast<float>(zero_point);
+	matrix<Q> values(m.rows(), m.cols());
+	int cols = m.cols();
+	parallel_for(0, m.rows(), parallel_grain(cols), [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+		{
+			const T* src = m.row_data(r);
+			Q* dst = values.row_data(r);
+			for (int c = 0; c < cols; ++c)
+			{
+				float v = std::min(q_max, std::max(-q_max, static_cast<float>(src[c]) * inverse + shift));
+				dst[c] = static_cast<Q>(v + (v >= 0.0f ? 0.5f : -0.5f));
+			}
+		}
+	});
+	return quantized_matrix<Q>(values, scale, zero_point);
+}
+
+/**
+ * \brief Quantizes matrix choosing parameters covering its range of values
+ *
+ * Scale and zero point are chosen so that minimal and maximal element
+ * (extended to include zero) map to ends of symmetric range of type Q.
+ *
+ * \param m Matrix to quantize
+ * \return Quantized matrix
+*/
+template<typename Q, typename T>
+inline quantized_matrix<Q> quantize(const matrix<T>& m)
+{
+	float low = 0.0f, high = 0.0f;
+	for (int r = 0; r < m.rows(); ++r)
+	{
+		const T* row = m.row_data(r);
+		for (int c = 0; c < m.cols(); ++c)
+		{
+			float v = static_cast<float>(row[c]);
+			low = std::min(low, v);
+			high = std::max(high, v);
+		}
+	}
+	const float q_max = static_cast<float>(std::numeric_limits<Q>::max());
+	float scale = (high > low) ? (high - low) / (2.0f * q_max) : 1.0f;
+	float zero = -q_max - low / scale;
+	int zero_point = static_cast<int>(zero + (zero >= 0.0f ? 0.5f : -0.5f));
+	zero_point = std::min(static_cast<int>(q_max), std::max(-static_cast<int>(q_max), zero_point));
+	return quantize<Q>(m, scale, zero_point);
+}
+
+/**
+ * \brief Converts quantized matrix back to floats
+ *
+ * \param q Quantized matrix
+ * \return Matrix of real values
+*/
+template<typename Q>
+inline matrix<float> dequantize(const quantized_matrix<Q>& q)
+{
+	matrix<float> result(q.rows(), q.cols());
+	const float scale = q.scale();
+	const float zero = static_cast<float>(q.zero_point());
+	int cols = q.cols();
+	parallel_for(0, q.rows(), parallel_grain(cols), [&](int begin, int end)
+	{
+		for (int r = begin; r < end; ++r)
+		{
+			const Q* src = q.values().row_data(r);
+			float* dst = result.row_data(r);
+			for (int c = 0; c < cols; ++c)
+				dst[c] = scale * (static_cast<float>(src[c]) - zero);
+		}
+	});
+	return result;
+}
+
+namespace detail {
+
+static const int qgemm_k_align = 64; //!< Padding of packed rows (in elements)
+static const int qgemm_mr = 16; //!< Number of rows of A packed at once
+
+/**
+ * \brief Calculates four dot products of packed integer rows
+ *
+ * Generic version, accumulates in 64-bit integers, so sums of products
+ * of wider types (e.g. std::int16_t) do not overflow.
+*/
+template<typename Q>
+inline void qdot4(const Q* a, const Q* const* b, int k, std::int64_t* out)
+{
+	for (int j = 0; j < 4; ++j)
+	{
+		std::int64_t s = 0;
+		for (int p = 0; p < k; ++p)
+			s += static_cast<std::int64_t>(a[p]) * static_cast<std::int64_t>(b[j][p]);
+		out[j] = s;
+	}
+}
+
+#if defined(__AVX512VNNI__) && defined(__AVX512BW__)
+static const int qgemm_bias = 128; //!< Bias added to elements of A by int8 kernel
+
+/**
+ * \brief Calculates four dot products of packed int8 rows (AVX-512 VNNI)
+ *
+ * VPDPBUSD multiplies unsigned bytes by signed ones, so 128 is added to
+ * elements of A. Results contain additional 128 * sum(b) term, which is
+ * removed by caller.
+*/
+template<>
+inline void qdot4<std::int8_t>(const std::int8_t* a, const std::int8_t* const* b, int k, std::int64_t* out)
+{
+	const __m512i bias = _mm512_set1_epi8(static_cast<char>(0x80));
+	__m512i acc[4] = { _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512(), _mm512_setzero_si512() };
+	for (int p = 0; p < k; p += 64)
+	{
+		__m512i va = _mm512_xor_si512(_mm512_loadu_si512(a + p), bias);
+		for (int j = 0; j < 4; ++j)
+			acc[j] = _mm512_dpbusd_epi32(acc[j], va, _mm512_loadu_si512(b[j] + p));
+	}
+	for (int j = 0; j < 4; ++j)
+		out[j] = _mm512_reduce_add_epi32(acc[j]);
+}
+#elif defined(__AVX2__)
+static const int qgemm_bias = 0; //!< Bias added to elements of A by int8 kernel
+
+/**
+ * \brief Calculates four dot products of packed int8 rows (AVX2)
+ *
+ * PMADDUBSW multiplies unsigned bytes by signed ones, so |a| is multiplied
+ * by b with sign of a. Products of pairs fit 16 bits exactly as long as
+ * elements are in range [-127, 127].
+*/
+template<>
+inline void qdot4<std::int8_t>(const std::int8_t* a, const std::int8_t* const* b, int k, std::int64_t* out)
+{
+	const __m256i ones = _mm256_set1_epi16(1);
+	__m256i acc[4] = { _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256(), _mm256_setzero_si256() };
+	for (int p = 0; p < k; p += 32)
+	{
+		__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p));
+		__m256i va_abs = _mm256_abs_epi8(va);
+		for (int j = 0; j < 4; ++j)
+		{
+			__m256i vb = _mm256_sign_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(b[j] + p)), va);
+			acc[j] = _mm256_add_epi32(acc[j], _mm256_madd_epi16(_mm256_maddubs_epi16(va_abs, vb), ones));
+		}
+	}
+	for (int j = 0; j < 4; ++j)
+	{
+		__m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc[j]), _mm256_extracti128_si256(acc[j], 1));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0x4e));
+		s = _mm_add_epi32(s, _mm_shuffle_epi32(s, 0xb1));
+		out[j] = _mm_cvtsi128_si32(s);
+	}
+}
+#else
+static const int qgemm_bias = 0; //!< Bias added to elements of A by int8 kernel
+#endif
+
+}
+
+/**
+ * \brief Multiplies quantized matrices with integer accumulation
+ *
+ * Calculates C = (A - zero_point(A)) * (B - zero_point(B)) in integers.
+ * Product of real values equals scale(A) * scale(B) * C. For std::int8_t
+ * elements vectorized kernels accumulate in 32 bits (AVX-512 VNNI or AVX2
+ * PMADDUBSW, depending on compilation target), which is exact for k below
+ * 65536; they require elements in range [-127, 127], as produced by
+ * mn::quantize. Other types (e.g. std::int16_t) are accumulated in 64-bit
+ * integers. Zero points are applied in 64 bits, so every element of C is
+ * exact as long as it fits in 32 bits. Columns of B are packed
+ * (transposed) into thread-local buffer and rows of A are processed in
+ * parallel.
+ *
+ * \param a Quantized matrix A
+ * \param b Quantized matrix B
+ * \param c Matrix C (result)
+ * \throws mn::matrix_exception
+*/
+template<typename Q>
+inline void qgemm(const quantized_matrix<Q>& a, const quantized_matrix<Q>& b, matrix<std::int32_t>& c)
+{
+	int m = a.rows(), k = a.cols(), n = b.cols();
+	if (b.rows() != k || c.rows() != m || c.cols() != n)
+		throw matrix_exception("dimensions mismatch");
+	c.detach();
+
+	const int bias = std::is_same<Q, std::int8_t>::value ? detail::qgemm_bias : 0;
+	int kp = (k + detail::qgemm_k_align - 1) / detail::qgemm_k_align * detail::qgemm_k_align;
+	int np = (n + 3) / 4 * 4;
+	Q* packed_b = detail::scratch<Q>(static_cast<std::size_t>(np) * kp, 1);
+	std::int64_t* sum_b = detail::scratch<std::int64_t>(np, 0);
+	parallel_for(0, np, parallel_grain(kp), [&](int begin, int end)
+	{
+		for (int j = begin; j < end; ++j)
+		{
+			Q* dst = packed_b + static_cast<std::size_t>(j) * kp;
+			std::int64_t s = 0;
+			for (int p = 0; p < kp; ++p)
+			{
+				dst[p] = (j < n && p < k) ? b.values().row_data(p)[j] : Q(0);
+				s += dst[p];
+			}
+			sum_b[j] = s;
+		}
+	});
+
+	const std::int64_t za = a.zero_point(), zb = b.zero_point();
+	const int nb = std::max(4, (1 << 18) / kp / 4 * 4);
+	parallel_for(0, m, parallel_grain(static_cast<long long>(n) * k / 16), [&](int begin, int end)
+	{
+		Q* rows = detail::scratch<Q>(static_cast<std::size_t>(detail::qgemm_mr) * kp, 2);
+		std::int64_t sum_a[detail::qgemm_mr];
+		for (int ib = begin; ib < end; ib += detail::qgemm_mr)
+		{
+			int mr = std::min(detail::qgemm_mr, end - ib);
+			for (int i = 0; i < mr; ++i)
+			{
+				const Q* src = a.values().row_data(ib + i);
+				Q* dst = rows + static_cast<std::size_t>(i) * kp;
+				sum_a[i] = 0;
+				for (int p = 0; p < kp; ++p)
+				{
+					dst[p] = p < k ? src[p] : Q(0);
+					sum_a[i] += dst[p];
+				}
+			}
+			for (int jb = 0; jb < np; jb += nb)
+			{
+				for (int i = 0; i < mr; ++i)
+				{
+					std::int32_t* ci = detail::view_row(c, ib + i);
+					for (int j = jb; j < std::min(np, jb + nb); j += 4)
+					{
+						const Q* cols[4];
+						for (int q = 0; q < 4; ++q)
+							cols[q] = packed_b + static_cast<std::size_t>(j + q) * kp;
+						std::int64_t raw[4];
+						detail::qdot4(rows + static_cast<std::size_t>(i) * kp, cols, kp, raw);
+						for (int q = 0; q < 4 && j + q < n; ++q)
+							ci[j + q] = static_cast<std::int32_t>(raw[q] - (bias + za) * sum_b[j + q] - zb * sum_a[i] + k * za * zb);
+					}
+				}
+			}
+		}
+	});
+}
+
+/**
+ * \brief Multiplies quantized matrices
+ *
+ * Uses mn::qgemm and converts result to real values.
+ *
+ * \param a Quantized matrix A
+ * \param b Quantized matrix B
+ * \return New matrix containing product of real values
+ * \throws mn::matrix_exception
+*/
+template<typename Q>
+inline matrix<float> operator*(const quantized_matrix<Q>& a, const quantized_matrix<Q>& b)
+{
+	matrix<std::int32_t> c(a.rows(), b.cols());
+	qgemm(a, b, c);
+	return dequantize(quantized_matrix<std::int32_t>(c, a.scale() * b.scale(), 0));
+}
+
+}
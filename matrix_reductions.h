@@ -0,0 +1,584 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "matrix_exception.h"
+#include "matrix_blas.h"
+#include "matrix_parallel.h"
+#include "matrix_precision.h"
+
+namespace mn {
+
+/**
+ * \brief Selects direction of reduction
+*/
+enum class along
+{
+	rows, //!< Every row is reduced to single value (result is column vector)
+	cols //!< Every column is reduced to single value (result is row vector)
+};
+
+/**
+ * \brief Selects matrix norm
+*/
+enum class norm_type
+{
+	frobenius, //!< Square root of sum of squares of all elements
+	one, //!< Maximal sum of absolute values in column
+	infinity //!< Maximal sum of absolute values in row
+};
+
+/**
+ * \brief Selects how parallel reductions split their work
+*/
+enum class summation
+{
+	fast, //!< One block of rows per task, results may differ with number of threads
+	reproducible //!< Blocks of fixed size, results are bitwise identical for any number of threads
+};
+
+/**
+ * \brief Returns default summation mode of reductions
+ *
+ * Mode may be modified directly, e.g.
+ * mn::default_summation() = mn::summation::reproducible, or overridden
+ * per call.
+ *
+ * \return Reference to default summation mode
+*/
+inline summation& default_summation()
+{
+	static summation mode = summation::fast;
+	return mode;
+}
+
+namespace detail {
+
+/**
+ * \brief Reduces contiguous array to single value
+ *
+ * Elements are accumulated with s = f(s, x) into eight independent
+ * accumulators, so the loop may be vectorized by compiler, and then
+ * accumulators are merged with g. Elements of other types than A are
+ * converted in short chunks first.
+*/
+template<typename A, typename T, typename F, typename G>
+inline A reduce_row(const T* x, int n, A init, F f, G g)
+{
+	A xs[256];
+	int chunk = std::is_same<A, T>::value ? std::max(n, 1) : 256;
+	A s[8] = { init, init, init, init, init, init, init, init };
+	for (int i = 0; i < n; i += chunk)
+	{
+		int len = std::min(chunk, n - i);
+		const A* y = converted(x + i, len, xs);
+		int j = 0;
+		for (; j + 8 <= len; j += 8)
+		{
+			for (int l = 0; l < 8; ++l)
+				s[l] = f(s[l], y[j + l]);
+		}
+		for (; j < len; ++j)
+			s[0] = f(s[0], y[j]);
+	}
+	return g(g(g(s[0], s[1]), g(s[2], s[3])), g(g(s[4], s[5]), g(s[6], s[7])));
+}
+
+/**
+ * \brief Reduces range of rows in parallel blocks
+ *
+ * Range [0, n) is split into blocks of at least grain rows, which are
+ * reduced by f(begin, end) in parallel. Partial results are merged
+ * pairwise with g. In reproducible mode number of blocks depends only on
+ * n and grain, so order of operations does not depend on number of threads.
+*/
+template<typename R, typename F, typename G>
+inline R reduce_blocks(int n, int grain, F f, G g, summation mode)
+{
+	int blocks = (n + grain - 1) / std::max(1, grain);
+	if (mode == summation::fast)
+		blocks = std::min(blocks, 4 * get_num_threads());
+	blocks = std::max(1, blocks);
+	std::vector<R> partial(blocks);
+	thread_pool::instance().run(blocks, [&](int b)
+	{
+		partial[b] = f(static_cast<int>(static_cast<long long>(n) * b / blocks), static_cast<int>(static_cast<long long>(n) * (b + 1) / blocks));
+	});
+	for (int width = 1; width < blocks; width *= 2)
+	{
+		for (int b = 0; b + width < blocks; b += 2 * width)
+			partial[b] = g(partial[b], partial[b + width]);
+	}
+	return partial[0];
+}
+
+/**
+ * \brief Reduces all elements of matrix to single value
+ *
+ * Rows are reduced in parallel blocks.
+*/
+template<typename A, typename T, typename F, typename G>
+inline A reduce(const matrix<T>& m, A init, F f, G g, summation mode)
+{
+	int cols = m.cols();
+	return reduce_blocks<A>(m.rows(), parallel_grain(cols), [&](int begin, int end)
+	{
+		A s = init;
+		for (int r = begin; r < end; ++r)
+			s = g(s, reduce_row(m.row_data(r), cols, init, f, g));
+		return s;
+	}, g, mode);
+}
+
+/**
+ * \brief Reduces every row or every column of matrix to single value
+ *
+ * Rows are reduced in parallel. Columns are reduced in parallel blocks of
+ * columns, accumulating whole row segments at once. Every value is reduced
+ * by single thread, so results never depend on number of threads.
+*/
+template<typename A, typename T, typename F, typename G>
+inline matrix<A> reduce(const matrix<T>& m, along dir, A init, F f, G g)
+{
+	int rows = m.rows(), cols = m.cols();
+	if (dir == along::rows)
+	{
+		matrix<A> result(rows, 1);
+		parallel_for(0, rows, parallel_grain(cols), [&](int begin, int end)
+		{
+			for (int r = begin; r < end; ++r)
+				*result.row_data(r) = reduce_row(m.row_data(r), cols, init, f, g);
+		});
+		return result;
+	}
+
+	matrix<A> result(1, cols);
+	A* out = result.row_data(0);
+	parallel_for(0, cols, parallel_grain(rows), [&](int begin, int end)
+	{
+		std::fill(out + begin, out + end, init);
+		for (int r = 0; r < rows; ++r)
+		{
+			const T* x = m.row_data(r);
+			for (int c = begin; c < end; ++c)
+				out[c] = f(out[c], static_cast<A>(x[c]));
+		}
+	});
+	return result;
+}
+
+/**
+ * \brief Throws exception if matrix has no elements
+ *
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void require_elements(const matrix<T>& m)
+{
+	if (m.rows() == 0 || m.cols() == 0)
+		throw matrix_exception("empty matrix");
+}
+
+/**
+ * \brief Returns absolute value of number
+*/
+template<typename A>
+inline A absolute(A x)
+{
+	return x < A(0) ? -x : x;
+}
+
+/**
+ * \brief Returns position of first element equal to value in matrix
+*/
+template<typename T, typename A>
+inline std::pair<int, int> find_first(const matrix<T>& m, A value)
+{
+	for (int r = 0; r < m.rows(); ++r)
+	{
+		const T* x = m.row_data(r);
+		for (int c = 0; c < m.cols(); ++c)
+		{
+			if (static_cast<A>(x[c]) == value)
+				return std::make_pair(r, c);
+		}
+	}
+	return std::make_pair(0, 0);
+}
+
+/**
+ * \brief Returns position of extreme element of every row or column
+ *
+ * better(x, y) returns true if x should replace y.
+*/
+template<typename T, typename F>
+inline matrix<int> arg_extreme(const matrix<T>& m, along dir, F better)
+{
+	typedef accumulator_t<T> A;
+	int rows = m.rows(), cols = m.cols();
+	if (dir == along::rows)
+	{
+		matrix<int> result(rows, 1);
+		parallel_for(0, rows, parallel_grain(cols), [&](int begin, int end)
+		{
+			for (int r = begin; r < end; ++r)
+			{
+				const T* x = m.row_data(r);
+				A best = reduce_row(x, cols, static_cast<A>(x[0]),
+					[&](A s, A v) { return better(v, s) ? v : s; }, [&](A s, A v) { return better(v, s) ? v : s; });
+				int c = 0;
+				while (c + 1 < cols && static_cast<A>(x[c]) != best)
+					++c;
+				*result.row_data(r) = c;
+			}
+		});
+		return result;
+	}
+
+	matrix<int> result(1, cols);
+	int* index = result.row_data(0);
+	parallel_for(0, cols, parallel_grain(rows), [&](int begin, int end)
+	{
+		std::vector<A> best(m.row_data(0) + begin, m.row_data(0) + end);
+		std::fill(index + begin, index + end, 0);
+		for (int r = 1; r < rows; ++r)
+		{
+			const T* x = m.row_data(r);
+			for (int c = begin; c < end; ++c)
+			{
+				A v = static_cast<A>(x[c]);
+				if (better(v, best[c - begin]))
+				{
+					best[c - begin] = v;
+					index[c] = r;
+				}
+			}
+		}
+	});
+	return result;
+}
+
+}
+
+/**
+ * \brief Calculates sum of all elements of matrix
+ *
+ * Rows are summed using vectorizable kernel with several accumulators,
+ * blocks of rows are summed in parallel. Works on submatrices without
+ * copying. Elements are accumulated in type A (see mn::accumulator).
+ *
+ * \param m Matrix
+ * \param mode Summation mode (see mn::summation)
+ * \return Sum of elements
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline A sum(const matrix<T>& m, summation mode = default_summation())
+{
+	return detail::reduce(m, A(0), [](A s, A x) { return s + x; }, [](A x, A y) { return x + y; }, mode);
+}
+
+/**
+ * \brief Calculates sums of elements of every row or every column
+ *
+ * \param m Matrix
+ * \param dir Direction of reduction
+ * \return Column vector of sums of rows or row vector of sums of columns
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline matrix<A> sum(const matrix<T>& m, along dir)
+{
+	return detail::reduce(m, dir, A(0), [](A s, A x) { return s + x; }, [](A x, A y) { return x + y; });
+}
+
+/**
+ * \brief Calculates product of all elements of matrix
+ *
+ * \param m Matrix
+ * \param mode Summation mode (see mn::summation)
+ * \return Product of elements
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline A prod(const matrix<T>& m, summation mode = default_summation())
+{
+	return detail::reduce(m, A(1), [](A s, A x) { return s * x; }, [](A x, A y) { return x * y; }, mode);
+}
+
+/**
+ * \brief Calculates products of elements of every row or every column
+ *
+ * \param m Matrix
+ * \param dir Direction of reduction
+ * \return Column vector of products of rows or row vector of products of columns
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline matrix<A> prod(const matrix<T>& m, along dir)
+{
+	return detail::reduce(m, dir, A(1), [](A s, A x) { return s * x; }, [](A x, A y) { return x * y; });
+}
+
+/**
+ * \brief Returns minimal element of matrix
+ *
+ * \param m Matrix
+ * \return Minimal element
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline T min(const matrix<T>& m)
+{
+	typedef accumulator_t<T> A;
+	detail::require_elements(m);
+	auto f = [](A x, A y) { return std::min(x, y); };
+	return static_cast<T>(detail::reduce(m, static_cast<A>(*m.row_data(0)), f, f, summation::fast));
+}
+
+/**
+ * \brief Returns minimal elements of every row or every column
+ *
+ * \param m Matrix
+ * \param dir Direction of reduction
+ * \return Column vector of minima of rows or row vector of minima of columns
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<accumulator_t<T>> min(const matrix<T>& m, along dir)
+{
+	typedef accumulator_t<T> A;
+	detail::require_elements(m);
+	auto f = [](A x, A y) { return std::min(x, y); };
+	return detail::reduce(m, dir, static_cast<A>(*m.row_data(0)), f, f);
+}
+
+/**
+ * \brief Returns maximal element of matrix
+ *
+ * \param m Matrix
+ * \return Maximal element
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline T max(const matrix<T>& m)
+{
+	typedef accumulator_t<T> A;
+	detail::require_elements(m);
+	auto f = [](A x, A y) { return std::max(x, y); };
+	return static_cast<T>(detail::reduce(m, static_cast<A>(*m.row_data(0)), f, f, summation::fast));
+}
+
+/**
+ * \brief Returns maximal elements of every row or every column
+ *
+ * \param m Matrix
+ * \param dir Direction of reduction
+ * \return Column vector of maxima of rows or row vector of maxima of columns
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<accumulator_t<T>> max(const matrix<T>& m, along dir)
+{
+	typedef accumulator_t<T> A;
+	detail::require_elements(m);
+	auto f = [](A x, A y) { return std::max(x, y); };
+	return detail::reduce(m, dir, static_cast<A>(*m.row_data(0)), f, f);
+}
+
+/**
+ * \brief Returns position of minimal element of matrix
+ *
+ * Minimal value is found by vectorized reduction first, then position of
+ * its first occurrence (in row-by-row order) is searched.
+ *
+ * \param m Matrix
+ * \return Pair of row and column index
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline std::pair<int, int> argmin(const matrix<T>& m)
+{
+	return detail::find_first(m, static_cast<accumulator_t<T>>(min(m)));
+}
+
+/**
+ * \brief Returns positions of minimal elements of every row or every column
+ *
+ * \param m Matrix
+ * \param dir Direction of reduction
+ * \return Column vector of column indexes or row vector of row indexes
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<int> argmin(const matrix<T>& m, along dir)
+{
+	typedef accumulator_t<T> A;
+	detail::require_elements(m);
+	return detail::arg_extreme(m, dir, [](A x, A y) { return x < y; });
+}
+
+/**
+ * \brief Returns position of maximal element of matrix
+ *
+ * Maximal value is found by vectorized reduction first, then position of
+ * its first occurrence (in row-by-row order) is searched.
+ *
+ * \param m Matrix
+ * \return Pair of row and column index
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline std::pair<int, int> argmax(const matrix<T>& m)
+{
+	return detail::find_first(m, static_cast<accumulator_t<T>>(max(m)));
+}
+
+/**
+ * \brief Returns positions of maximal elements of every row or every column
+ *
+ * \param m Matrix
+ * \param dir Direction of reduction
+ * \return Column vector of column indexes or row vector of row indexes
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<int> argmax(const matrix<T>& m, along dir)
+{
+	typedef accumulator_t<T> A;
+	detail::require_elements(m);
+	return detail::arg_extreme(m, dir, [](A x, A y) { return x > y; });
+}
+
+/**
+ * \brief Calculates matrix norm
+ *
+ * Norms one and infinity are maxima of sums of rows or columns, which are
+ * always calculated in fixed order.
+ *
+ * \param m Matrix
+ * \param type Norm type
+ * \param mode Summation mode (see mn::summation)
+ * \return Norm of matrix
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline A norm(const matrix<T>& m, norm_type type = norm_type::frobenius, summation mode = default_summation())
+{
+	auto add_abs = [](A s, A x) { return s + detail::absolute(x); };
+	auto add = [](A x, A y) { return x + y; };
+	if (type == norm_type::frobenius)
+		return static_cast<A>(std::sqrt(detail::reduce(m, A(0), [](A s, A x) { return s + x * x; }, add, mode)));
+	matrix<A> sums = detail::reduce(m, type == norm_type::one ? along::cols : along::rows, A(0), add_abs, add);
+	A result = 0;
+	for (auto i = sums.begin(); i != sums.end(); ++i)
+		result = std::max(result, *i);
+	return result;
+}
+
+/**
+ * \brief Calculates vector norms of every row or every column
+ *
+ * Frobenius norm of row or column is its Euclidean norm, norm one is sum
+ * of absolute values and infinity norm is maximal absolute value.
+ *
+ * \param m Matrix
+ * \param dir Direction of reduction
+ * \param type Norm type
+ * \return Column vector of norms of rows or row vector of norms of columns
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline matrix<A> norm(const matrix<T>& m, along dir, norm_type type = norm_type::frobenius)
+{
+	auto add = [](A x, A y) { return x + y; };
+	if (type == norm_type::one)
+		return detail::reduce(m, dir, A(0), [](A s, A x) { return s + detail::absolute(x); }, add);
+	if (type == norm_type::infinity)
+	{
+		auto f = [](A s, A x) { return std::max(s, detail::absolute(x)); };
+		return detail::reduce(m, dir, A(0), f, f);
+	}
+	matrix<A> result = detail::reduce(m, dir, A(0), [](A s, A x) { return s + x * x; }, add);
+	for (auto i = result.begin(); i != result.end(); ++i)
+		*i = static_cast<A>(std::sqrt(*i));
+	return result;
+}
+
+/**
+ * \brief Calculates trace of square matrix (sum of diagonal elements)
+ *
+ * \param m Square matrix
+ * \return Trace of matrix
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline A trace(const matrix<T>& m)
+{
+	if (!m.is_square())
+		throw matrix_exception("not square matrix");
+	A s = 0;
+	for (int i = 0; i < m.rows(); ++i)
+		s += static_cast<A>(m.row_data(i)[i]);
+	return s;
+}
+
+/**
+ * \brief Calculates dot product of two matrices (sum of products of corresponding elements)
+ *
+ * For vectors it is ordinary dot product; row and column vectors with the
+ * same number of elements may be mixed (column vector is packed into
+ * contiguous buffer first). Rows are multiplied with vectorized kernel,
+ * blocks of rows (or of vector elements) are processed in parallel.
+ *
+ * \param a Matrix A
+ * \param b Matrix B
+ * \param mode Summation mode (see mn::summation)
+ * \return Dot product
+ * \throws mn::matrix_exception
+*/
+template<typename T, typename A = accumulator_t<T>>
+inline A dot(const matrix<T>& a, const matrix<T>& b, summation mode = default_summation())
+{
+	if (a.rows() != b.rows() || a.cols() != b.cols())
+	{
+		bool vectors = (a.rows() == 1 || a.cols() == 1) && (b.rows() == 1 || b.cols() == 1);
+		if (!vectors || detail::vector_size(a) != detail::vector_size(b))
+			throw matrix_exception("dimensions mismatch");
+		int n = detail::vector_size(a);
+		const T* x = detail::contiguous(a.row_data(0), detail::vector_inc(a), n, 0);
+		const T* y = detail::contiguous(b.row_data(0), detail::vector_inc(b), n, 1);
+		return detail::reduce_blocks<A>(n, parallel_grain(1), [&](int begin, int end)
+		{
+			return detail::dot<A>(x + begin, y + begin, end - begin);
+		}, [](A s, A t) { return s + t; }, mode);
+	}
+	int cols = a.cols();
+	return detail::reduce_blocks<A>(a.rows(), parallel_grain(cols), [&](int begin, int end)
+	{
+		A s = 0;
+		for (int r = begin; r < end; ++r)
+			s += detail::dot<A>(a.row_data(r), b.row_data(r), cols);
+		return s;
+	}, [](A x, A y) { return x + y; }, mode);
+}
+
+}
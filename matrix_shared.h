@@ -0,0 +1,365 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "matrix_exception.h"
+#include "matrix_precision.h"
+
+namespace mn {
+
+namespace detail {
+
+/**
+ * \brief Returns code of element type stored in header of shared matrix
+ *
+ * Types other than listed ones are identified only by size of element.
+*/
+template<typename T>
+inline std::uint32_t type_code()
+{
+	return std::is_same<T, float>::value ? 1 :
+		std::is_same<T, double>::value ? 2 :
+		std::is_same<T, std::int8_t>::value ? 3 :
+		std::is_same<T, std::uint8_t>::value ? 4 :
+		std::is_same<T, std::int16_t>::value ? 5 :
+		std::is_same<T, std::uint16_t>::value ? 6 :
+		std::is_same<T, std::int32_t>::value ? 7 :
+		std::is_same<T, std::uint32_t>::value ? 8 :
+		std::is_same<T, std::int64_t>::value ? 9 :
+		std::is_same<T, std::uint64_t>::value ? 10 :
+		std::is_same<T, bfloat16>::value ? 11 :
+		std::is_same<T, float16>::value ? 12 : 0;
+}
+
+/**
+ * \brief Header stored at the beginning of shared memory object or file of matrix
+ *
+ * Elements are stored row-by-row at data_offset bytes from the beginning.
+*/
+struct shared_header
+{
+	char magic[8]; //!< "mnmatrix"
+	std::uint32_t version; //!< Version of layout
+	std::uint32_t type; //!< Code of element type (see type_code)
+	std::uint32_t element_size; //!< Size of element in bytes
+	std::atomic<std::uint32_t> published; //!< Non-zero when creator finished writing elements (published or finalized)
+	std::int64_t rows; //!< Number of rows
+	std::int64_t cols; //!< Number of columns
+	std::uint64_t data_offset; //!< Offset of first element (multiple of page size)
+};
+
+const char shared_magic[8] = { 'm', 'n', 'm', 'a', 't', 'r', 'i', 'x' }; //!< Magic bytes of header
+
+/**
+ * \brief mn::detail::shared_mappings
+ *
+ * Address ranges of shared mappings created by mn::detail::map_shared.
+ * Allows to recognize memory whose pages may be dropped without losing
+ * elements (see mn::advise).
+*/
+struct shared_mappings
+{
+	std::mutex lock; //!< Guards ranges
+	std::map<std::uintptr_t, std::uintptr_t> ranges; //!< End of every mapping by its first byte
+
+	/**
+	 * \brief Returns global registry of shared mappings
+	 *
+	 * Registry is never destroyed, as matrices with static storage duration
+	 * may unmap their files after other static objects are destroyed.
+	*/
+	static shared_mappings& instance()
+	{
+		static shared_mappings* mappings = new shared_mappings();
+		return *mappings;
+	}
+
+	/**
+	 * \brief Checks if range [addr, addr + bytes) lies within single shared mapping
+	*/
+	bool contain(const void* addr, std::size_t bytes)
+	{
+		std::uintptr_t first = reinterpret_cast<std::uintptr_t>(addr);
+		std::lock_guard<std::mutex> guard(lock);
+		auto it = ranges.upper_bound(first);
+		return it != ranges.begin() && first + bytes <= (--it)->second;
+	}
+};
+
+/**
+ * \brief Maps shared memory object or file and returns matrix using its elements
+ *
+ * File descriptor is closed. Mapping is released with last copy of matrix.
+*/
+template<typename T>
+inline matrix<T> map_shared(int fd, std::size_t bytes, int prot, int rows, int cols, std::size_t offset)
+{
+	void* base = mmap(nullptr, bytes, prot, MAP_SHARED, fd, 0);
+	close(fd);
+	if (base == MAP_FAILED)
+		throw matrix_exception("cannot map shared memory");
+	std::uintptr_t first = reinterpret_cast<std::uintptr_t>(base);
+	shared_mappings& mappings = shared_mappings::instance();
+	{
+		std::lock_guard<std::mutex> guard(mappings.lock);
+		mappings.ranges[first] = first + bytes;
+	}
+	T* data = reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+	return matrix<T>(data, rows, cols, [base, bytes, first](T*)
+	{
+		shared_mappings& mappings = shared_mappings::instance();
+		{
+			std::lock_guard<std::mutex> guard(mappings.lock);
+			mappings.ranges.erase(first);
+		}
+		munmap(base, bytes);
+	});
+}
+
+/**
+ * \brief Resizes empty shared memory object or file, maps it and writes header
+ *
+ * Elements are zeros and header is marked as not ready.
+*/
+template<typename T>
+inline matrix<T> create_mapping(int fd, int rows, int cols)
+{
+	static_assert(std::is_trivially_copyable<T>::value, "only trivially copyable types may be shared");
+	if (rows < 0 || cols < 0)
+	{
+		close(fd);
+		throw matrix_exception("invalid dimensions");
+	}
+	std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	std::size_t offset = (sizeof(shared_header) + page - 1) / page * page;
+	if (cols != 0 && static_cast<std::size_t>(rows) > (std::numeric_limits<std::size_t>::max() - offset) / sizeof(T) / cols)
+	{
+		close(fd);
+		throw matrix_exception("matrix too large");
+	}
+	std::size_t bytes = offset + static_cast<std::size_t>(rows) * cols * sizeof(T);
+	if (ftruncate(fd, static_cast<off_t>(bytes)) != 0)
+	{
+		close(fd);
+		throw matrix_exception("cannot resize shared memory");
+	}
+	matrix<T> m = map_shared<T>(fd, bytes, PROT_READ | PROT_WRITE, rows, cols, offset);
+	shared_header* h = reinterpret_cast<shared_header*>(reinterpret_cast<char*>(m.row_data(0)) - offset);
+	std::memcpy(h->magic, shared_magic, sizeof(h->magic));
+	h->version = 1;
+	h->type = type_code<T>();
+	h->element_size = sizeof(T);
+	h->rows = rows;
+	h->cols = cols;
+	h->data_offset = offset;
+	h->published.store(0, std::memory_order_release);
+	return m;
+}
+
+/**
+ * \brief Validates header of shared memory object or file and maps its elements
+ *
+ * \param not_ready Message of exception thrown if header is not marked as ready
+*/
+template<typename T>
+inline matrix<T> open_mapping(int fd, bool read_only, const char* not_ready)
+{
+	struct stat st;
+	shared_header h;
+	if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(h) || pread(fd, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h)))
+	{
+		close(fd);
+		throw matrix_exception("invalid shared matrix");
+	}
+	std::size_t bytes = static_cast<std::size_t>(st.st_size);
+	bool valid = std::memcmp(h.magic, shared_magic, sizeof(h.magic)) == 0 && h.version == 1 &&
+		h.rows >= 0 && h.cols >= 0 && h.rows <= std::numeric_limits<int>::max() && h.cols <= std::numeric_limits<int>::max() &&
+		h.data_offset <= bytes && (h.cols == 0 || static_cast<std::uint64_t>(h.rows) <= (bytes - h.data_offset) / sizeof(T) / h.cols);
+	if (!valid)
+	{
+		close(fd);
+		throw matrix_exception("invalid shared matrix");
+	}
+	if (h.type != type_code<T>() || h.element_size != sizeof(T))
+	{
+		close(fd);
+		throw matrix_exception("element type mismatch");
+	}
+	if (h.published.load() == 0)
+	{
+		close(fd);
+		throw matrix_exception(not_ready);
+	}
+	return map_shared<T>(fd, bytes, read_only ? PROT_READ : PROT_READ | PROT_WRITE,
+		static_cast<int>(h.rows), static_cast<int>(h.cols), static_cast<std::size_t>(h.data_offset));
+}
+
+/**
+ * \brief Marks header of shared memory object or file as ready
+ *
+ * If durable is true, elements are written to storage before header is
+ * marked and header is written to storage afterwards. File descriptor is closed.
+*/
+inline void mark_ready(int fd, bool durable)
+{
+	if (durable && fsync(fd) != 0)
+	{
+		close(fd);
+		throw matrix_exception("cannot sync matrix");
+	}
+	void* base = mmap(nullptr, sizeof(shared_header), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (base == MAP_FAILED)
+	{
+		close(fd);
+		throw matrix_exception("cannot map shared memory");
+	}
+	static_cast<shared_header*>(base)->published.store(1, std::memory_order_release);
+	bool synced = !durable || msync(base, sizeof(shared_header), MS_SYNC) == 0;
+	munmap(base, sizeof(shared_header));
+	synced = synced && (!durable || fsync(fd) == 0);
+	close(fd);
+	if (!synced)
+		throw matrix_exception("cannot sync matrix");
+}
+
+}
+
+/**
+ * \brief Creates matrix stored in named POSIX shared memory object
+ *
+ * Shared memory object (shm_open) contains small header describing
+ * dimensions and element type, followed by elements. Elements are
+ * initialized to zeros. Other processes may attach it with
+ * mn::attach_shared_matrix after creator calls mn::publish_shared_matrix.
+ * Object exists until mn::remove_shared_matrix is called, even after all
+ * processes detach. Only trivially copyable element types may be shared.
+ *
+ * \param name Name of shared memory object (e.g. "/model")
+ * \param rows Number of matrix rows
+ * \param cols Number of matrix columns
+ * \return Writable matrix using shared memory
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> create_shared_matrix(const std::string& name, int rows, int cols)
+{
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0)
+		throw matrix_exception("cannot create shared memory");
+	try
+	{
+		return detail::create_mapping<T>(fd, rows, cols);
+	}
+	catch (...)
+	{
+		shm_unlink(name.c_str());
+		throw;
+	}
+}
+
+/**
+ * \brief Marks shared matrix as ready to be attached by other processes
+ *
+ * Should be called after all elements are written by creator.
+ *
+ * \param name Name of shared memory object
+ * \throws mn::matrix_exception
+*/
+inline void publish_shared_matrix(const std::string& name)
+{
+	int fd = shm_open(name.c_str(), O_RDWR, 0);
+	if (fd < 0)
+		throw matrix_exception("cannot open shared memory");
+	detail::mark_ready(fd, false);
+}
+
+/**
+ * \brief Creates shared matrix containing copy of matrix and publishes it
+ *
+ * \param name Name of shared memory object
+ * \param m Matrix to share
+ * \return Writable matrix using shared memory
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> share_matrix(const std::string& name, const matrix<T>& m)
+{
+	matrix<T> shared = create_shared_matrix<T>(name, m.rows(), m.cols());
+	copy_block(m, shared);
+	publish_shared_matrix(name);
+	return shared;
+}
+
+/**
+ * \brief Attaches matrix published in named POSIX shared memory object
+ *
+ * Maps shared memory object in O(1) time, without copying elements, after
+ * validating its header. Read-only matrix must not be modified (writes
+ * cause segmentation fault). Memory is unmapped when last copy of matrix
+ * is destroyed.
+ *
+ * \param name Name of shared memory object
+ * \param read_only Maps elements read-only
+ * \return Matrix using shared memory
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline matrix<T> attach_shared_matrix(const std::string& name, bool read_only = true)
+{
+	int fd = shm_open(name.c_str(), read_only ? O_RDONLY : O_RDWR, 0);
+	if (fd < 0)
+		throw matrix_exception("cannot open shared memory");
+	return detail::open_mapping<T>(fd, read_only, "shared matrix not published");
+}
+
+/**
+ * \brief Removes name of shared memory object
+ *
+ * Memory is released when all processes unmap it. Attached matrices remain valid.
+ *
+ * \param name Name of shared memory object
+*/
+inline void remove_shared_matrix(const std::string& name)
+{
+	shm_unlink(name.c_str());
+}
+
+}
+
+#endif
@@ -0,0 +1,214 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+#include "matrix_exception.h"
+#include "matrix_blas.h"
+#include "matrix_elementwise.h"
+#include "matrix_parallel.h"
+
+namespace mn {
+
+/**
+ * \brief mn::strassen_settings
+ *
+ * Controls usage of Strassen-Winograd algorithm by operator*.
+ * Results of Strassen-Winograd multiplication differ slightly from
+ * results of classical algorithm (its error bound is weaker), so it is
+ * disabled by default and has to be enabled explicitly.
+*/
+struct strassen_settings
+{
+	bool enabled; //!< Allows operator* to use Strassen-Winograd algorithm
+	int cutoff; //!< Minimal dimension of product split recursively (smaller are passed to mn::gemm)
+	int parallel_levels; //!< Number of top recursion levels computing seven sub-products in parallel
+};
+
+/**
+ * \brief Returns global Strassen-Winograd settings
+ *
+ * Settings may be modified directly, e.g. mn::strassen_config().enabled = true.
+ *
+ * \return Reference to settings
+*/
+inline strassen_settings& strassen_config()
+{
+	static strassen_settings settings = { false, 4096, 1 };
+	return settings;
+}
+
+namespace detail {
+
+/**
+ * \brief Returns number of elements of workspace needed by Strassen-Winograd recursion
+*/
+inline std::size_t strassen_workspace(int m, int k, int n, int level)
+{
+	const strassen_settings& s = strassen_config();
+	if (std::min(std::min(m, k), n) < std::max(2, s.cutoff))
+		return 0;
+	std::size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+	std::size_t local = 4 * m2 * k2 + 4 * k2 * n2 + 3 * m2 * n2;
+	std::size_t child = strassen_workspace(m / 2, k / 2, n / 2, level + 1);
+	return local + (level < s.parallel_levels ? 7 : 1) * child;
+}
+
+/**
+ * \brief Returns matrix using part of workspace as memory block and advances workspace pointer
+*/
+template<typename T>
+inline matrix<T> workspace_matrix(T*& ws, int rows, int cols)
+{
+	matrix<T> m(std::shared_ptr<T>(std::shared_ptr<T>(), ws), rows, cols);
+	ws += static_cast<std::size_t>(rows) * cols;
+	return m;
+}
+
+/**
+ * \brief Performs single step of Strassen-Winograd recursion (C = A * B)
+ *
+ * Splits even part of operands into quadrants, computes seven sub-products
+ * (recursively, in parallel on top levels) and combines them. Odd rows or
+ * columns are handled by mn::gemm. Temporary matrices are placed in
+ * preallocated workspace.
+*/
+template<typename T>
+inline void strassen_step(const matrix<T>& a, const matrix<T>& b, matrix<T>& c, T* ws, int level)
+{
+	int m = a.rows(), k = a.cols(), n = b.cols();
+	if (std::min(std::min(m, k), n) < std::max(2, strassen_config().cutoff))
+	{
+		gemm(T(1), a, b, T(0), c);
+		return;
+	}
+
+	int m2 = m / 2, k2 = k / 2, n2 = n / 2;
+	matrix<T> a11 = a.view(0, m2 - 1, 0, k2 - 1), a12 = a.view(0, m2 - 1, k2, 2 * k2 - 1);
+	matrix<T> a21 = a.view(m2, 2 * m2 - 1, 0, k2 - 1), a22 = a.view(m2, 2 * m2 - 1, k2, 2 * k2 - 1);
+	matrix<T> b11 = b.view(0, k2 - 1, 0, n2 - 1), b12 = b.view(0, k2 - 1, n2, 2 * n2 - 1);
+	matrix<T> b21 = b.view(k2, 2 * k2 - 1, 0, n2 - 1), b22 = b.view(k2, 2 * k2 - 1, n2, 2 * n2 - 1);
+	matrix<T> c11 = c.view(0, m2 - 1, 0, n2 - 1), c12 = c.view(0, m2 - 1, n2, 2 * n2 - 1);
+	matrix<T> c21 = c.view(m2, 2 * m2 - 1, 0, n2 - 1), c22 = c.view(m2, 2 * m2 - 1, n2, 2 * n2 - 1);
+
+	matrix<T> s1 = workspace_matrix(ws, m2, k2), s2 = workspace_matrix(ws, m2, k2);
+	matrix<T> s3 = workspace_matrix(ws, m2, k2), s4 = workspace_matrix(ws, m2, k2);
+	matrix<T> t1 = workspace_matrix(ws, k2, n2), t2 = workspace_matrix(ws, k2, n2);
+	matrix<T> t3 = workspace_matrix(ws, k2, n2), t4 = workspace_matrix(ws, k2, n2);
+	matrix<T> p1 = workspace_matrix(ws, m2, n2), p5 = workspace_matrix(ws, m2, n2), p6 = workspace_matrix(ws, m2, n2);
+
+	auto add = [](const T& x, const T& y) { return x + y; };
+	auto sub = [](const T& x, const T& y) { return x - y; };
+	combine(a21, a22, s1, add);
+	combine(s1, a11, s2, sub);
+	combine(a11, a21, s3, sub);
+	combine(a12, s2, s4, sub);
+	combine(b12, b11, t1, sub);
+	combine(b22, t1, t2, sub);
+	combine(b22, b12, t3, sub);
+	combine(t2, b21, t4, sub);
+
+	// P2, P3, P4 and P7 are stored directly in quadrants of C
+	const matrix<T>* lhs[7] = { &a11, &a12, &s4, &a22, &s1, &s2, &s3 };
+	const matrix<T>* rhs[7] = { &b11, &b21, &b22, &t4, &t1, &t2, &t3 };
+	matrix<T>* dst[7] = { &p1, &c11, &c12, &c21, &p5, &p6, &c22 };
+	std::size_t child = strassen_workspace(m2, k2, n2, level + 1);
+	if (level < strassen_config().parallel_levels)
+	{
+		thread_pool::instance().run(7, [&](int i)
+		{
+			strassen_step(*lhs[i], *rhs[i], *dst[i], ws + i * child, level + 1);
+		});
+	}
+	else
+	{
+		for (int i = 0; i < 7; ++i)
+			strassen_step(*lhs[i], *rhs[i], *dst[i], ws, level + 1);
+	}
+
+	combine(c11, p1, c11, add);
+	combine(p6, p1, p6, add);
+	combine(c22, p6, c22, add);
+	combine(c22, c21, c21, sub);
+	combine(c22, p5, c22, add);
+	combine(p6, p5, p6, add);
+	combine(c12, p6, c12, add);
+
+	if (k > 2 * k2)
+	{
+		matrix<T> c_even = c.view(0, 2 * m2 - 1, 0, 2 * n2 - 1);
+		gemm(T(1), a.view(0, 2 * m2 - 1, k - 1, k - 1), b.view(k - 1, k - 1, 0, 2 * n2 - 1), T(1), c_even);
+	}
+	if (n > 2 * n2)
+	{
+		matrix<T> c_col = c.view(0, m - 1, n - 1, n - 1);
+		gemm(T(1), a, b.view(0, k - 1, n - 1, n - 1), T(0), c_col);
+	}
+	if (m > 2 * m2)
+	{
+		matrix<T> c_row = c.view(m - 1, m - 1, 0, 2 * n2 - 1);
+		gemm(T(1), a.view(m - 1, m - 1, 0, k - 1), b.view(0, k - 1, 0, 2 * n2 - 1), T(0), c_row);
+	}
+}
+
+}
+
+/**
+ * \brief Multiplies two matrices using Strassen-Winograd algorithm (C = A * B)
+ *
+ * Operands are split recursively until any dimension drops below cutoff
+ * from mn::strassen_config(), then blocked mn::gemm is used. Whole workspace
+ * needed by recursion is allocated once, as thread-local buffer reused by
+ * subsequent calls on the same thread; it is kept until thread exits or
+ * mn::release_strassen_workspace is called. C may be submatrix, but must
+ * not share memory with A or B.
+ *
+ * \param a Matrix A
+ * \param b Matrix B
+ * \param c Matrix C (result)
+ * \throws mn::matrix_exception
+*/
+template<typename T>
+inline void strassen(const matrix<T>& a, const matrix<T>& b, matrix<T>& c)
+{
+	if (a.cols() != b.rows() || c.rows() != a.rows() || c.cols() != b.cols())
+		throw matrix_exception("dimensions mismatch");
+	c.detach();
+	std::size_t size = detail::strassen_workspace(a.rows(), a.cols(), b.cols(), 0);
+	detail::strassen_step(a, b, c, size ? detail::scratch<T>(size, 3) : nullptr, 0);
+}
+
+/**
+ * \brief Frees workspace of mn::strassen kept by current thread
+ *
+ * Workspace for elements of type T is allocated again by next call of
+ * mn::strassen on this thread.
+*/
+template<typename T>
+inline void release_strassen_workspace()
+{
+	detail::release_scratch<T>(3);
+}
+
+}
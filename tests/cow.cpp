@@ -0,0 +1,111 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+
+#include "matrix.h"
+#include "test.h"
+
+// Copy-on-write matrices: sharing until first write, kernels writing shared copies
+static mn::matrix<float> numbered(int rows, int cols)
+{
+	mn::matrix<float> m(rows, cols);
+	for (int r = 0; r < rows; ++r)
+		for (int c = 0; c < cols; ++c)
+			m.row_data(r)[c] = static_cast<float>(r * cols + c) / 64.0f;
+	m.set_copy_on_write(true);
+	return m;
+}
+
+static const float* block(const mn::matrix<float>& m)
+{
+	return m.row_data(0);
+}
+
+static bool same(const mn::matrix<float>& a, const mn::matrix<float>& b, float tolerance = 0.0f)
+{
+	for (int r = 0; r < a.rows(); ++r)
+		for (int c = 0; c < a.cols(); ++c)
+			if (std::fabs(a.row_data(r)[c] - b.row_data(r)[c]) > tolerance * std::fabs(b.row_data(r)[c]))
+				return false;
+	return true;
+}
+
+int main()
+{
+	const int n = 96;
+	mn::matrix<float> a = numbered(n, n);
+	mn::matrix<float> original = a.copy();
+
+	// Copies share memory block until written
+	mn::matrix<float> b = a;
+	CHECK(b.is_copy_on_write());
+	CHECK(block(a) == block(b));
+	b[0][0] = -1.0f;
+	CHECK(block(a) != block(b));
+	CHECK(static_cast<const mn::matrix<float>&>(a)[0][0] == 0.0f);
+	CHECK(static_cast<const mn::matrix<float>&>(b)[0][0] == -1.0f);
+
+	// Sole owner is written in place
+	const float* own = block(b);
+	b[1][1] = 2.0f;
+	CHECK(block(b) == own);
+
+	// Every kernel writing its result detaches it once and leaves other copies intact
+	mn::matrix<float> c = a;
+	mn::syrk(1.0f, a, 0.0f, c);
+	CHECK(same(a, original));
+	bool symmetric = true;
+	for (int i = 0; i < n; ++i)
+		for (int j = 0; j < n; ++j)
+			symmetric = symmetric && c.row_data(i)[j] == c.row_data(j)[i];
+	CHECK(symmetric);
+
+	mn::matrix<float> d = a;
+	mn::gemm(1.0f, a, a, 0.0f, d, mn::transposition::none, mn::transposition::transposed);
+	CHECK(same(a, original));
+	CHECK(same(d, c, 1e-5f));
+
+	mn::matrix<float> e = a;
+	mn::ger(1.0f, a.submatrix(0, n - 1, 0, 0), a.submatrix(0, 0, 0, n - 1), e);
+	CHECK(same(a, original));
+	CHECK(e.row_data(1)[2] == original.row_data(1)[2] + original.row_data(1)[0] * original.row_data(0)[2]);
+
+	mn::matrix<float> f = a;
+	f += a;
+	CHECK(same(a, original));
+	CHECK(f.row_data(5)[7] == 2.0f * original.row_data(5)[7]);
+
+	mn::matrix<float> g = a;
+	g.transform([](float x) { return x + 1.0f; });
+	CHECK(same(a, original));
+	CHECK(g.row_data(3)[4] == original.row_data(3)[4] + 1.0f);
+
+	mn::matrix<float> h = a;
+	mn::fma(a, a, a, h);
+	CHECK(same(a, original));
+
+	// Submatrix written while its parent is shared again
+	mn::matrix<float> s = a.submatrix(0, 1, 0, 1);
+	mn::matrix<float> shared = a;
+	CHECK_THROWS(s.row_data(0));
+	CHECK_THROWS(s.transform([](float x) { return x; }));
+	return test::failures();
+}
@@ -0,0 +1,57 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <type_traits>
+#include <vector>
+
+#include "matrix.h"
+#include "test.h"
+
+// Wrapping foreign memory and std::mdspan views (when standard library provides them)
+int main()
+{
+	std::vector<float> buffer(5 * 8);
+	for (std::size_t i = 0; i < buffer.size(); ++i)
+		buffer[i] = static_cast<float>(i);
+	mn::matrix<float> m = mn::matrix<float>::wrap(buffer.data(), 5, 6, 8);
+	CHECK(m.rows() == 5 && m.cols() == 6 && m.stride() == 8);
+	m[2][3] = -1.0f;
+	CHECK(buffer[2 * 8 + 3] == -1.0f);
+	CHECK_THROWS(mn::matrix<float>::wrap(buffer.data(), 5, 9, 8));
+	CHECK_THROWS(mn::matrix<float>::wrap(nullptr, 5, 6));
+
+#if defined(__cpp_lib_mdspan)
+	mn::matrix<float> sub = m.submatrix(1, 3, 2, 5);
+	auto span = mn::to_mdspan(sub);
+	CHECK(span.extent(0) == 3 && span.extent(1) == 4 && span.stride(0) == 8);
+	span[1, 1] = 7.0f;
+	CHECK(buffer[2 * 8 + 3] == 7.0f);
+
+	const mn::matrix<float>& view = sub;
+	auto read_only = mn::to_mdspan(view);
+	static_assert(std::is_same<decltype(read_only)::element_type, const float>::value, "constant matrix gives constant elements");
+	CHECK((read_only[2, 3] == buffer[3 * 8 + 5]));
+
+	mn::matrix<float> back = mn::from_mdspan(span);
+	CHECK(back.rows() == 3 && back.cols() == 4 && back.stride() == 8);
+	CHECK(static_cast<const mn::matrix<float>&>(back)[1][1] == 7.0f);
+#endif
+	return test::failures();
+}
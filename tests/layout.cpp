@@ -0,0 +1,169 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <sstream>
+
+#include "matrix.h"
+#include "test.h"
+
+// Column-major matrices: element access, iterators, conversions, kernels and streams
+typedef mn::matrix<double, mn::layout::col_major> col_matrix;
+
+static mn::matrix<double> numbered(int rows, int cols, double shift)
+{
+	mn::matrix<double> m(rows, cols);
+	for (int r = 0; r < rows; ++r)
+		for (int c = 0; c < cols; ++c)
+			m[r][c] = (r * 7 + c * 3) % 11 - shift;
+	return m;
+}
+
+template<mn::layout L>
+static bool equal(const mn::matrix<double>& expected, const mn::matrix<double, L>& m)
+{
+	if (m.rows() != expected.rows() || m.cols() != expected.cols())
+		return false;
+	for (int r = 0; r < m.rows(); ++r)
+		for (int c = 0; c < m.cols(); ++c)
+			if (m[r][c] != expected[r][c])
+				return false;
+	return true;
+}
+
+static const mn::matrix<double>& as_row(const mn::matrix<double>& m)
+{
+	return m;
+}
+
+template<mn::layout L>
+static mn::matrix<double, L> in_layout(const mn::matrix<double>& m);
+
+template<>
+mn::matrix<double> in_layout<mn::layout::row_major>(const mn::matrix<double>& m)
+{
+	return m.copy();
+}
+
+template<>
+col_matrix in_layout<mn::layout::col_major>(const mn::matrix<double>& m)
+{
+	return mn::to_col_major(m);
+}
+
+template<mn::layout LA, mn::layout LB, mn::layout LC>
+static bool gemm_matches(mn::transposition ta, mn::transposition tb)
+{
+	mn::matrix<double> a = ta == mn::transposition::none ? numbered(5, 7, 4) : numbered(7, 5, 4);
+	mn::matrix<double> b = tb == mn::transposition::none ? numbered(7, 3, 2) : numbered(3, 7, 2);
+	mn::matrix<double> c = numbered(5, 3, 1), expected = c.copy();
+	mn::gemm(2.0, a, b, 0.5, expected, ta, tb);
+	mn::matrix<double, LC> result = in_layout<LC>(c);
+	mn::gemm(2.0, in_layout<LA>(a), in_layout<LB>(b), 0.5, result, ta, tb);
+	return equal(expected, result);
+}
+
+template<mn::layout LA, mn::layout LB, mn::layout LC>
+static bool gemm_all()
+{
+	const mn::transposition none = mn::transposition::none, transposed = mn::transposition::transposed;
+	return gemm_matches<LA, LB, LC>(none, none) && gemm_matches<LA, LB, LC>(none, transposed) &&
+		gemm_matches<LA, LB, LC>(transposed, none) && gemm_matches<LA, LB, LC>(transposed, transposed);
+}
+
+int main()
+{
+	typedef mn::layout L;
+	mn::matrix<double> m = numbered(70, 45, 5);
+	col_matrix c = mn::to_col_major(m);
+	CHECK(equal(m, c));
+	CHECK(c.rows() == 70 && c.cols() == 45);
+	CHECK(mn::to_row_major(c) == m);
+
+	// Columns are contiguous
+	bool contiguous = true;
+	for (int j = 0; j < c.cols(); ++j)
+		for (int i = 0; i < c.rows(); ++i)
+			contiguous = contiguous && c.col_data(j)[i] == as_row(m)[i][j];
+	CHECK(contiguous);
+	CHECK(c.storage() == m.transpose());
+	CHECK(c.transpose() == m.transpose());
+
+	// Row and column iterators keep their meaning, elements are walked column by column
+	auto row = c.row(3);
+	CHECK(*(row.first_element()) == as_row(m)[3][0]);
+	auto col = c.col(4);
+	CHECK(*(++col.first_element()) == as_row(m)[1][4]);
+	CHECK(*(++c.begin()) == as_row(m)[1][0]);
+	int rows_n = 0;
+	for (auto r = c.first_row(); r != c.last_row(); ++r)
+		++rows_n;
+	CHECK(rows_n == 70);
+
+	// Submatrices and writes share memory
+	col_matrix sub = c.submatrix(10, 19, 5, 7);
+	CHECK(equal(m.submatrix(10, 19, 5, 7), sub));
+	sub[0][0] = 100.0;
+	CHECK(static_cast<const col_matrix&>(c)[10][5] == 100.0);
+	CHECK(c.copy() == c);
+
+	// Kernels accept every combination of layouts
+	CHECK((gemm_all<L::row_major, L::row_major, L::col_major>()));
+	CHECK((gemm_all<L::row_major, L::col_major, L::row_major>()));
+	CHECK((gemm_all<L::row_major, L::col_major, L::col_major>()));
+	CHECK((gemm_all<L::col_major, L::row_major, L::row_major>()));
+	CHECK((gemm_all<L::col_major, L::row_major, L::col_major>()));
+	CHECK((gemm_all<L::col_major, L::col_major, L::row_major>()));
+	CHECK((gemm_all<L::col_major, L::col_major, L::col_major>()));
+
+	mn::matrix<double> a = numbered(6, 4, 3), x = numbered(4, 1, 2), xt = numbered(6, 1, 2);
+	col_matrix ac = mn::to_col_major(a);
+	mn::matrix<double> y(6, 1), yc(6, 1), z(4, 1), zc(4, 1);
+	mn::gemv(1.0, a, x, 0.0, y);
+	mn::gemv(1.0, ac, x, 0.0, yc);
+	CHECK(y == yc);
+	mn::gemv(1.0, a, xt, 0.0, z, mn::transposition::transposed);
+	mn::gemv(1.0, ac, mn::to_col_major(xt), 0.0, zc, mn::transposition::transposed);
+	CHECK(z == zc);
+
+	mn::matrix<double> s(6, 6);
+	col_matrix sc(6, 6);
+	mn::syrk(1.0, a, 0.0, s);
+	mn::syrk(1.0, ac, 0.0, sc);
+	CHECK(equal(s, sc));
+
+	mn::matrix<double> g = a.copy();
+	col_matrix gc = mn::to_col_major(a);
+	mn::ger(2.0, xt, x.transpose(), g);
+	mn::ger(2.0, xt, x.transpose(), gc);
+	CHECK(equal(g, gc));
+
+	// Streams read and write rows in both layouts
+	std::stringstream text;
+	text << ac;
+	std::stringstream printed;
+	printed << a;
+	CHECK(text.str() == printed.str());
+	std::stringstream values("1 2 3 4 5 6");
+	col_matrix read(2, 3);
+	values >> read;
+	CHECK(static_cast<const col_matrix&>(read)[0][2] == 3.0 && static_cast<const col_matrix&>(read)[1][0] == 4.0);
+	CHECK(read.col_data(1)[1] == 5.0);
+	return test::failures();
+}
@@ -0,0 +1,80 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+#include "matrix.h"
+#include "test.h"
+
+// File-backed matrices: creation, finalization, reopening, sync and page hints
+int main()
+{
+#if defined(__unix__) || defined(__APPLE__)
+	const std::string path = "mapped-" + std::to_string(getpid()) + ".mnm";
+	{
+		mn::matrix<double> m = mn::create_mapped_matrix<double>(path, 1000, 700);
+		CHECK(static_cast<const mn::matrix<double>&>(m)[999][699] == 0.0);
+		CHECK_THROWS(mn::open_mapped_matrix<double>(path));
+		for (int r = 0; r < m.rows(); ++r)
+			for (int c = 0; c < m.cols(); ++c)
+				m[r][c] = r * 1000.0 + c;
+		mn::sync_matrix(m.submatrix(10, 19, 0, 699));
+		mn::sync_matrix(m, true);
+		mn::finalize_mapped_matrix(path);
+	}
+	CHECK_THROWS(mn::open_mapped_matrix<float>(path));
+
+	// Elements are read back lazily from complete file
+	mn::matrix<double> in = mn::open_mapped_matrix<double>(path);
+	const mn::matrix<double>& read = in;
+	CHECK(in.rows() == 1000 && in.cols() == 700);
+	CHECK(read[0][0] == 0.0 && read[999][699] == 999699.0 && read[500][7] == 500007.0);
+	mn::advise(in, mn::access_pattern::sequential);
+	mn::advise(in.submatrix(0, 99, 0, 699), mn::access_pattern::willneed);
+
+	// Writes through writable mapping reach file and survive dropped pages
+	{
+		mn::matrix<double> out = mn::open_mapped_matrix<double>(path, true);
+		out[3][4] = -1.0;
+		mn::sync_matrix(out);
+		mn::advise(out, mn::access_pattern::dontneed);
+		CHECK(static_cast<const mn::matrix<double>&>(out)[3][4] == -1.0);
+		CHECK(static_cast<const mn::matrix<double>&>(out)[998][1] == 998001.0);
+	}
+	CHECK(read[3][4] == -1.0);
+	CHECK(mn::open_mapped_matrix<double>(path).row_data(3)[4] == -1.0);
+
+	// Copy in memory is independent of file
+	mn::matrix<double> copy = in.copy();
+	copy[0][0] = 5.0;
+	mn::advise(copy, mn::access_pattern::dontneed);
+	CHECK(static_cast<const mn::matrix<double>&>(copy)[0][0] == 5.0);
+	CHECK(read[0][0] == 0.0);
+
+	std::remove(path.c_str());
+	CHECK_THROWS(mn::open_mapped_matrix<double>(path));
+#endif
+	return test::failures();
+}
@@ -0,0 +1,90 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "matrix.h"
+#include "test.h"
+
+// Error bounds of fast math functions documented in mn::math
+int main()
+{
+	// Every 61st float bit pattern (bounds in documentation were measured on every fourth)
+	double exp_max = 0, log_max = 0, tanh_max = 0, sigmoid_max = 0;
+	for (std::uint64_t u = 0; u < (std::uint64_t(1) << 32); u += 61)
+	{
+		std::uint32_t bits = static_cast<std::uint32_t>(u);
+		float x;
+		std::memcpy(&x, &bits, sizeof(x));
+		if (x != x)
+			continue;
+		double e = std::exp(static_cast<double>(x));
+		if (e >= std::numeric_limits<float>::min() && e <= std::numeric_limits<float>::max())
+			exp_max = std::max(exp_max, test::ulp_error(mn::math::exp(x), e));
+		if (x > 0.0f && x <= std::numeric_limits<float>::max())
+			log_max = std::max(log_max, test::ulp_error(mn::math::log(x), std::log(static_cast<double>(x))));
+		double t = std::tanh(static_cast<double>(x));
+		if (std::fabs(t) >= std::numeric_limits<float>::min())
+			tanh_max = std::max(tanh_max, test::ulp_error(mn::math::tanh(x), t));
+		double s = 1.0 / (1.0 + std::exp(-static_cast<double>(x)));
+		if (s >= std::numeric_limits<float>::min())
+			sigmoid_max = std::max(sigmoid_max, test::ulp_error(mn::math::sigmoid(x), s));
+	}
+	CHECK(exp_max <= 1.02);
+	CHECK(log_max <= 0.83);
+	CHECK(tanh_max <= 1.34);
+	CHECK(sigmoid_max <= 2.48);
+
+	// Special values
+	CHECK(mn::math::exp(-std::numeric_limits<float>::infinity()) == 0.0f);
+	CHECK(std::isinf(mn::math::exp(100.0f)));
+	CHECK(std::isinf(mn::math::log(0.0f)) && mn::math::log(0.0f) < 0.0f);
+	CHECK(std::isnan(mn::math::log(-1.0f)));
+	CHECK(mn::math::tanh(-std::numeric_limits<float>::infinity()) == -1.0f);
+	CHECK(mn::math::sigmoid(std::numeric_limits<float>::infinity()) == 1.0f);
+
+	// Negative bases of pow with integer exponents
+	CHECK(std::fabs(mn::math::pow(-2.0f, 2.0f) - 4.0f) < 1e-5f);
+	CHECK(std::fabs(mn::math::pow(-2.0f, 3.0f) + 8.0f) < 1e-5f);
+	CHECK(std::fabs(mn::math::pow(-0.5f, -1.0f) + 2.0f) < 1e-5f);
+	CHECK(std::isnan(mn::math::pow(-2.0f, 0.5f)));
+	CHECK(mn::math::pow(-3.0f, 0.0f) == 1.0f);
+	mn::matrix<float> m(1, 4);
+	m[0][0] = -3.0f;
+	m[0][1] = -1.5f;
+	m[0][2] = 0.0f;
+	m[0][3] = 2.5f;
+	mn::matrix<float> squares = mn::pow(m, 2.0f);
+	const mn::matrix<float>& cs = squares;
+	for (int c = 0; c < 4; ++c)
+	{
+		float x = static_cast<const mn::matrix<float>&>(m)[0][c];
+		CHECK(test::ulp_error(cs[0][c], static_cast<double>(x) * x) <= 4.0);
+	}
+
+	// Precise versions call standard library
+	mn::matrix<double> d(1, 1);
+	d[0][0] = -2.0;
+	CHECK(static_cast<const mn::matrix<double>&>(mn::pow(d, 3.0, mn::accuracy::precise))[0][0] == -8.0);
+	return test::failures();
+}
@@ -0,0 +1,53 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "matrix.h"
+#include "test.h"
+
+// Placement of large memory blocks: huge pages and their statistics
+int main()
+{
+#if defined(__linux__)
+	mn::huge_page_config().mode = mn::huge_page_mode::transparent;
+	mn::huge_page_stats before = mn::huge_page_statistics();
+	{
+		mn::matrix<float> m(2048, 2048);
+		for (int r = 0; r < m.rows(); ++r)
+			m[r][0] = static_cast<float>(r);
+		mn::huge_page_stats stats = mn::huge_page_statistics();
+		CHECK(stats.blocks == before.blocks + 1);
+		CHECK(stats.requested_pages - before.requested_pages == stats.live_pages);
+		CHECK(stats.live_pages * mn::detail::huge_page_size() >= 2048 * 2048 * sizeof(float));
+		CHECK(stats.obtained_pages <= stats.live_pages);
+		CHECK(static_cast<const mn::matrix<float>&>(m)[2047][0] == 2047.0f);
+	}
+	mn::huge_page_stats after = mn::huge_page_statistics();
+	CHECK(after.blocks == before.blocks + 1);
+	CHECK(after.live_pages == 0);
+	CHECK(after.obtained_pages == 0);
+	{
+		mn::matrix<mn::bfloat16> h(2048, 2048);
+		CHECK(mn::huge_page_statistics().blocks == after.blocks + 1);
+		CHECK(static_cast<float>(static_cast<const mn::matrix<mn::bfloat16>&>(h)[2047][2047]) == 0.0f);
+	}
+	mn::huge_page_config().mode = mn::huge_page_mode::none;
+#endif
+	return test::failures();
+}
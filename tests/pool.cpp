@@ -0,0 +1,76 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <thread>
+#include <vector>
+
+#include "matrix.h"
+#include "test.h"
+
+// Buffer pool: per-thread caches and statistics summed over threads
+int main()
+{
+	mn::buffer_pool& pool = mn::buffer_pool::instance();
+	pool.trim();
+	mn::pool_stats before = pool.stats();
+
+	void* p = pool.allocate(1000, 64);
+	pool.deallocate(p, 1000, 64);
+	void* q = pool.allocate(1000, 64);
+	CHECK(q == p);
+	mn::pool_stats s = pool.stats();
+	CHECK(s.misses == before.misses + 1);
+	CHECK(s.hits == before.hits + 1);
+	CHECK(s.cached_bytes == before.cached_bytes);
+	pool.deallocate(q, 1000, 64);
+	CHECK(pool.stats().cached_bytes >= 1000);
+
+	const int threads = 4, rounds = 1000;
+	std::vector<std::thread> workers;
+	for (int t = 0; t < threads; ++t)
+		workers.push_back(std::thread([&pool]()
+		{
+			for (int i = 0; i < rounds; ++i)
+				pool.deallocate(pool.allocate(4096, 64), 4096, 64);
+		}));
+	for (std::size_t t = 0; t < workers.size(); ++t)
+		workers[t].join();
+	mn::pool_stats after = pool.stats();
+	CHECK(after.misses == s.misses + threads);
+	CHECK(after.hits == s.hits + threads * (rounds - 1));
+	CHECK(after.cached_bytes == pool.stats().cached_bytes);
+
+	{
+		mn::memory_scope scope(pool);
+		mn::matrix<float> m(16, 16);
+		m = m + m;
+	}
+	CHECK(pool.stats().hits + pool.stats().misses > after.hits + after.misses);
+
+	pool.trim();
+	CHECK(pool.stats().cached_bytes == 0);
+	std::size_t limit = pool.limit();
+	pool.set_limit(0);
+	void* r = pool.allocate(1000, 64);
+	pool.deallocate(r, 1000, 64);
+	CHECK(pool.stats().cached_bytes == 0);
+	pool.set_limit(limit);
+	return test::failures();
+}
@@ -0,0 +1,145 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cmath>
+#include <cstdint>
+
+#include "matrix.h"
+#include "test.h"
+
+// Reduced precision storage: conversions, element-wise operations and kernels computing in float
+template<typename H>
+bool same_bits(const mn::matrix<H>& a, const mn::matrix<H>& b)
+{
+	for (int r = 0; r < a.rows(); ++r)
+	{
+		for (int c = 0; c < a.cols(); ++c)
+		{
+			if (a.row_data(r)[c].bits != b.row_data(r)[c].bits)
+				return false;
+		}
+	}
+	return true;
+}
+
+template<typename H>
+void check_type()
+{
+	// Every number survives conversion to float and back (NaNs stay NaNs)
+	mn::matrix<H> all(256, 256);
+	for (int i = 0; i < 65536; ++i)
+		all.row_data(i / 256)[i % 256].bits = static_cast<std::uint16_t>(i);
+	mn::matrix<H> round_trip = mn::matrix_cast<H>(mn::matrix_cast<float>(all));
+	bool exact = true;
+	for (int i = 0; i < 65536; ++i)
+	{
+		const H& x = static_cast<const mn::matrix<H>&>(all).row_data(i / 256)[i % 256];
+		const H& y = static_cast<const mn::matrix<H>&>(round_trip).row_data(i / 256)[i % 256];
+		float f = x;
+		exact = exact && (f != f ? static_cast<float>(y) != static_cast<float>(y) : x.bits == y.bits);
+	}
+	CHECK(exact);
+
+	// Bulk conversions round like scalar ones
+	mn::matrix<float> values(37, 601);
+	for (int r = 0; r < values.rows(); ++r)
+	{
+		for (int c = 0; c < values.cols(); ++c)
+			values[r][c] = 0.01f * ((r * 601 + c) % 700) - 3.0f + 1e-4f * c;
+	}
+	mn::matrix<H> a = mn::matrix_cast<H>(values);
+	mn::matrix<H> b(a.rows(), a.cols()), c(a.rows(), a.cols());
+	bool rounded = true;
+	for (int r = 0; r < a.rows(); ++r)
+	{
+		for (int k = 0; k < a.cols(); ++k)
+		{
+			rounded = rounded && a.row_data(r)[k].bits == H(static_cast<const mn::matrix<float>&>(values)[r][k]).bits;
+			b[r][k] = H(1.0f + 0.001f * k);
+			c[r][k] = H(0.5f * r);
+		}
+	}
+	CHECK(rounded);
+
+	// Element-wise operations are computed in float and rounded once
+	const mn::matrix<H>& ca = a;
+	const mn::matrix<H>& cb = b;
+	const mn::matrix<H>& cc = c;
+	mn::matrix<H> sum(a.rows(), a.cols()), product(a.rows(), a.cols()), fused(a.rows(), a.cols()), exps(a.rows(), a.cols());
+	for (int r = 0; r < a.rows(); ++r)
+	{
+		for (int k = 0; k < a.cols(); ++k)
+		{
+			float x = ca[r][k], y = cb[r][k], z = cc[r][k];
+			sum[r][k] = H(x + y);
+			product[r][k] = H(x * y);
+			fused[r][k] = H(x * y + z);
+			exps[r][k] = H(mn::math::exp(x));
+		}
+	}
+	CHECK(same_bits(a + b, sum));
+	CHECK(same_bits(mn::hadamard(a, b), product));
+	CHECK(same_bits(mn::fma(a, b, c), fused));
+	CHECK(same_bits(mn::exp(a), exps));
+	CHECK(same_bits(a.map([](float x) { return mn::math::exp(x); }), exps));
+	CHECK(same_bits(a.zip_with(b, [](float x, float y) { return x + y; }), sum));
+	mn::matrix<H> transformed = a.copy();
+	transformed.transform(b, [](float x, float y) { return x * y; });
+	CHECK(same_bits(transformed, product));
+	mn::matrix<H> scaled = a.copy();
+	scaled *= H(2.0f);
+	CHECK(same_bits(scaled, a + a));
+
+	// Products are accumulated in float and rounded once
+	int n = 24, k = 4096;
+	mn::matrix<H> x(k, n);
+	mn::matrix<double> exact_x(k, n);
+	for (int r = 0; r < k; ++r)
+	{
+		for (int j = 0; j < n; ++j)
+		{
+			x[r][j] = H(1.0f + 0.0009765625f * ((r + j) % 3));
+			exact_x[r][j] = static_cast<const mn::matrix<H>&>(x)[r][j];
+		}
+	}
+	mn::matrix<H> gram(n, n), gram_t(n, n);
+	mn::syrk(H(1.0f), x, H(0.0f), gram, mn::transposition::transposed);
+	mn::gemm(H(1.0f), x, x, H(0.0f), gram_t, mn::transposition::transposed, mn::transposition::none);
+	mn::matrix<double> reference(n, n);
+	mn::syrk(1.0, exact_x, 0.0, reference, mn::transposition::transposed);
+	bool accurate = true;
+	for (int i = 0; i < n; ++i)
+	{
+		for (int j = 0; j < n; ++j)
+		{
+			H expected(static_cast<float>(static_cast<const mn::matrix<double>&>(reference)[i][j]));
+			accurate = accurate && static_cast<const mn::matrix<H>&>(gram)[i][j].bits == expected.bits;
+			accurate = accurate && static_cast<const mn::matrix<H>&>(gram_t)[i][j].bits == expected.bits;
+		}
+	}
+	CHECK(accurate);
+}
+
+int main()
+{
+	check_type<mn::bfloat16>();
+	check_type<mn::float16>();
+	return test::failures();
+}
@@ -0,0 +1,73 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+#include <vector>
+
+#include "matrix.h"
+#include "test.h"
+
+// Rows appended with push_row, reserved capacity and bounds of submatrices
+int main()
+{
+	// Reserved rows are not initialized, so they are not part of matrix
+	mn::matrix<double> m = mn::matrix<double>::ones(3, 4);
+	m.reserve(100);
+	CHECK(m.capacity() == 100);
+	CHECK(m.rows() == 3);
+	CHECK_THROWS(m.submatrix(0, 50, 0, m.cols() - 1));
+	CHECK_THROWS(m.submatrix(3, 3, 0, 0));
+	CHECK(m.submatrix(0, 2, 0, 3).rows() == 3);
+
+	// Appended rows become part of matrix
+	m.push_row(std::vector<double>(4, 2.0).data());
+	CHECK(m.rows() == 4);
+	CHECK(m.capacity() == 100);
+	CHECK(m.submatrix(3, 3, 0, 3).row_data(0)[3] == 2.0);
+	CHECK_THROWS(m.submatrix(4, 4, 0, 3));
+
+	// Row of matrix itself, also when appending reallocates memory block
+	mn::matrix<std::string> s(1, 3);
+	s[0][0] = "a";
+	s[0][1] = "b";
+	s[0][2] = "c";
+	const mn::matrix<std::string>& cs = s;
+	for (int i = 0; i < 10; ++i)
+		s.push_row(cs.row_data(i));
+	CHECK(s.rows() == 11);
+	CHECK(cs[10][2] == "c");
+
+	mn::matrix<double> v = mn::matrix<double>::ones(1, 1000);
+	for (int i = 0; i < 5; ++i)
+		v.push_row(v.submatrix(v.rows() - 1, v.rows() - 1, 0, 999));
+	CHECK(v.rows() == 6);
+	CHECK(v[5][999] == 1.0);
+
+	// Copy sharing memory block is not extended
+	mn::matrix<double> a = mn::matrix<double>::ones(2, 2);
+	a.reserve(10);
+	mn::matrix<double> b = a;
+	a.push_row(std::vector<double>(2, 3.0).data());
+	CHECK(a.rows() == 3);
+	CHECK(b.rows() == 2);
+	CHECK_THROWS(b.submatrix(2, 2, 0, 1));
+
+	return test::failures();
+}
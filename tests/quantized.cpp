@@ -0,0 +1,76 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdint>
+
+#include "matrix.h"
+#include "test.h"
+
+// Integer products of quantized matrices against 64-bit reference
+template<typename Q>
+static bool exact(const mn::quantized_matrix<Q>& a, const mn::quantized_matrix<Q>& b)
+{
+	mn::matrix<std::int32_t> c(a.rows(), b.cols());
+	mn::qgemm(a, b, c);
+	for (int i = 0; i < a.rows(); ++i)
+	{
+		for (int j = 0; j < b.cols(); ++j)
+		{
+			long long s = 0;
+			for (int p = 0; p < a.cols(); ++p)
+				s += (static_cast<long long>(a.values().row_data(i)[p]) - a.zero_point()) * (static_cast<long long>(b.values().row_data(p)[j]) - b.zero_point());
+			if (c.row_data(i)[j] != s)
+				return false;
+		}
+	}
+	return true;
+}
+
+template<typename Q>
+static mn::matrix<Q> values(int rows, int cols, int first, int range)
+{
+	mn::matrix<Q> m(rows, cols);
+	unsigned state = 12345;
+	for (int r = 0; r < rows; ++r)
+	{
+		for (int c = 0; c < cols; ++c)
+		{
+			state = state * 1103515245u + 12345u;
+			m.row_data(r)[c] = static_cast<Q>(first + static_cast<int>((state >> 8) % range));
+		}
+	}
+	return m;
+}
+
+int main()
+{
+	mn::quantized_matrix<std::int8_t> a8(values<std::int8_t>(37, 300, -127, 255), 0.1f, 3);
+	mn::quantized_matrix<std::int8_t> b8(values<std::int8_t>(300, 21, -127, 255), 0.2f, -5);
+	CHECK(exact(a8, b8));
+
+	// Raw products overflow 32 bits, differences from zero points do not
+	mn::quantized_matrix<std::int16_t> a16(values<std::int16_t>(9, 1024, 30000, 3), 1.0f, 30001);
+	mn::quantized_matrix<std::int16_t> b16(values<std::int16_t>(1024, 7, 30000, 3), 1.0f, 30001);
+	CHECK(exact(a16, b16));
+	mn::quantized_matrix<std::int16_t> c16(values<std::int16_t>(1024, 7, -32767, 65535), 1.0f, 0);
+	mn::quantized_matrix<std::int16_t> d16(values<std::int16_t>(9, 1024, -2, 5), 1.0f, 0);
+	CHECK(exact(d16, c16));
+	return test::failures();
+}
@@ -0,0 +1,53 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "matrix.h"
+#include "test.h"
+
+// Dot products of matrices and of row and column vectors
+int main()
+{
+	const int n = 100003;
+	mn::matrix<double> row(1, n), col(n, 1), other(n, 1);
+	double expected = 0.0;
+	for (int i = 0; i < n; ++i)
+	{
+		row[0][i] = i % 7;
+		col[i][0] = i % 5;
+		other[i][0] = i % 7;
+		expected += (i % 7) * (i % 5);
+	}
+	CHECK(mn::dot(row, col) == expected);
+	CHECK(mn::dot(col, row) == expected);
+	CHECK(mn::dot(other, col) == expected);
+	CHECK(mn::dot(row, col, mn::summation::reproducible) == expected);
+
+	// Column of submatrix is strided
+	mn::matrix<double> wide(n, 3);
+	for (int i = 0; i < n; ++i)
+		for (int j = 0; j < 3; ++j)
+			wide[i][j] = j == 1 ? i % 5 : -1.0;
+	CHECK(mn::dot(row, wide.submatrix(0, n - 1, 1, 1)) == expected);
+
+	mn::matrix<double> square(3, 3), flat(1, 9);
+	CHECK_THROWS(mn::dot(row, mn::matrix<double>(n - 1, 1)));
+	CHECK_THROWS(mn::dot(square, flat));
+	return test::failures();
+}
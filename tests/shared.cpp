@@ -0,0 +1,83 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include "matrix.h"
+#include "test.h"
+
+// Matrices in POSIX shared memory: publishing, attaching from other process and page hints
+int main()
+{
+#if defined(__unix__) || defined(__APPLE__)
+	const std::string name = "/mn-matrix-test-" + std::to_string(getpid());
+	mn::matrix<float> created = mn::create_shared_matrix<float>(name, 300, 500);
+	CHECK(static_cast<const mn::matrix<float>&>(created)[299][499] == 0.0f);
+	CHECK_THROWS(mn::create_shared_matrix<float>(name, 1, 1));
+	CHECK_THROWS(mn::attach_shared_matrix<float>(name));
+	for (int r = 0; r < created.rows(); ++r)
+		for (int c = 0; c < created.cols(); ++c)
+			created[r][c] = static_cast<float>(r - c);
+	mn::publish_shared_matrix(name);
+	CHECK_THROWS(mn::attach_shared_matrix<double>(name));
+
+	// Other process sees published elements and its writes are visible here
+	pid_t child = fork();
+	if (child == 0)
+	{
+		mn::matrix<float> attached = mn::attach_shared_matrix<float>(name, false);
+		bool same = attached.rows() == 300 && attached.cols() == 500 && static_cast<const mn::matrix<float>&>(attached)[123][45] == 78.0f;
+		attached[1][2] = 42.0f;
+		_exit(same ? 0 : 1);
+	}
+	int status = -1;
+	waitpid(child, &status, 0);
+	CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	CHECK(static_cast<const mn::matrix<float>&>(created)[1][2] == 42.0f);
+
+	// Dropped pages of shared memory are read again from object
+	mn::matrix<float> attached = mn::attach_shared_matrix<float>(name);
+	mn::advise(created, mn::access_pattern::dontneed);
+	CHECK(static_cast<const mn::matrix<float>&>(attached)[299][0] == 299.0f);
+	CHECK(static_cast<const mn::matrix<float>&>(created)[0][499] == -499.0f);
+
+	// Memory which is not shared is never dropped, including detached copy-on-write copies
+	mn::matrix<float> heap = created.copy();
+	mn::advise(heap, mn::access_pattern::dontneed);
+	CHECK(static_cast<const mn::matrix<float>&>(heap)[200][100] == 100.0f);
+	mn::matrix<float> cow = created;
+	cow.set_copy_on_write(true);
+	mn::matrix<float> other = cow;
+	cow[0][0] = 5.0f;
+	mn::advise(cow, mn::access_pattern::dontneed);
+	CHECK(static_cast<const mn::matrix<float>&>(cow)[0][0] == 5.0f);
+	CHECK(static_cast<const mn::matrix<float>&>(cow)[299][1] == 298.0f);
+
+	mn::remove_shared_matrix(name);
+	CHECK_THROWS(mn::attach_shared_matrix<float>(name));
+	CHECK(static_cast<const mn::matrix<float>&>(attached)[10][10] == 0.0f);
+#endif
+	return test::failures();
+}
@@ -0,0 +1,76 @@
+/*
+	mn-matrix
+
+	Open source C++ header-only library that provides basic matrix operations.
+	Copyright (C) 2015  Marek Nalepa
+
+	This program is free software: you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation, either version 3 of the License, or
+	(at your option) any later version.
+
+	This program is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * \brief Minimal checks used by test programs
+ *
+ * Every test program is a separate executable. Failed check prints its
+ * location and expression and makes program exit with non-zero status.
+*/
+namespace test {
+
+/**
+ * \brief Returns number of failed checks (exit status of test program)
+*/
+inline int& failures()
+{
+	static int count = 0;
+	return count;
+}
+
+/**
+ * \brief Records result of single check
+*/
+inline void check(bool passed, const char* expression, const char* file, int line)
+{
+	if (!passed)
+	{
+		std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+		++failures();
+	}
+}
+
+/**
+ * \brief Returns distance between two floats in units in the last place
+*/
+inline double ulp_error(float value, double exact)
+{
+	int exponent;
+	std::frexp(static_cast<float>(exact), &exponent);
+	return std::fabs(value - exact) / std::ldexp(1.0, exponent - 24);
+}
+
+}
+
+#define CHECK(expression) test::check(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+#define CHECK_THROWS(expression) \
+	do \
+	{ \
+		bool thrown = false; \
+		try { expression; } catch (const mn::matrix_exception&) { thrown = true; } \
+		test::check(thrown, #expression " throws", __FILE__, __LINE__); \
+	} while (false)